@@ -0,0 +1,256 @@
+/**
+ * @file    ab.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * A/B comparison of two tfc executables.
+ *
+ * The speed ratio is the time taken by A divided by the time taken by B,
+ * so a ratio above 1 means B is faster. The interval is found by
+ * resampling the interleaved pairs of runs, which keeps each A run with
+ * the B run made next to it.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "ab.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const std::vector<std::string> abOptions{ "-x", "-s", "-t", "-d", "-u", "-s -d", "-t -u", "-2 -s", "-8 -t" };
+
+static const int resamples{2000};
+static const double confidence{0.95};
+
+struct AbCase
+{
+    std::string profile;
+    std::string options;
+    std::vector<double> a{};
+    std::vector<double> b{};
+    bool identical{};
+};
+
+/**
+ * @brief Get the speed ratio of the median times and its confidence
+ * interval from a paired bootstrap.
+ *
+ * @param c the case with the times of both executables.
+ * @param low end of the interval.
+ * @param high end of the interval.
+ * @return double the speed ratio of B relative to A.
+ */
+static double speedRatio(const AbCase & c, double & low, double & high)
+{
+    std::mt19937_64 random{1};
+    std::uniform_int_distribution<size_t> pick{0, c.a.size() - 1};
+
+    std::vector<double> ratios(resamples);
+    std::vector<double> a(c.a.size());
+    std::vector<double> b(c.b.size());
+    for (auto & ratio : ratios)
+    {
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            const size_t j{pick(random)};
+            a[i] = c.a[j];
+            b[i] = c.b[j];
+        }
+        ratio = median(a) / median(b);
+    }
+
+    std::sort(ratios.begin(), ratios.end());
+    const double tail{(1 - confidence) / 2};
+    low = ratios[static_cast<size_t>(tail * (resamples - 1))];
+    high = ratios[static_cast<size_t>((1 - tail) * (resamples - 1))];
+
+    return median(c.a) / median(c.b);
+}
+
+/**
+ * @brief Run both executables on a file with the given options, alternating
+ * which goes first, and check that their first outputs match.
+ *
+ * @param config of the comparison.
+ * @param inputFileName of the generated input.
+ * @param dir working directory for the outputs.
+ * @param c the case, updated with the times and the comparison.
+ * @return int error value or 0 if no errors.
+ */
+static int runCase(const AbConfig & config, const std::string & inputFileName, const std::string & dir, AbCase & c)
+{
+    const std::string outputA{dir + "/abOutA.txt"};
+    const std::string outputB{dir + "/abOutB.txt"};
+    const std::string commandA{config.a + " " + c.options + " -i " + inputFileName + " -o " + outputA};
+    const std::string commandB{config.b + " " + c.options + " -i " + inputFileName + " -o " + outputB};
+
+    for (int i = 0; i < config.repeat; ++i)
+    {
+        Usage usageA{};
+        Usage usageB{};
+        const bool aFirst{i % 2 == 0};
+        if (spawn(aFirst ? commandA : commandB, aFirst ? usageA : usageB) ||
+            spawn(aFirst ? commandB : commandA, aFirst ? usageB : usageA))
+        {
+            std::cout << "  " << c.options << " on " << c.profile << " failed with status "
+                << usageA.status << " (A) and " << usageB.status << " (B)\n";
+
+            return 1;
+        }
+        c.a.push_back(usageA.elapsed);
+        c.b.push_back(usageB.elapsed);
+
+        if (i == 0)
+            c.identical = sameContent(outputA, outputB);
+    }
+
+    std::filesystem::remove(outputA);
+    std::filesystem::remove(outputB);
+
+    return 0;
+}
+
+
+/**
+ * @section A/B comparison implementation.
+ *
+ */
+
+/**
+ * @brief Compare two tfc executables over the option matrix on generated
+ * files of each profile, reporting the speed ratio of each case.
+ *
+ * @param dir working directory for the generated files.
+ * @param config of the comparison, with at least 2 runs of each.
+ * @return int error value or 0 if every output was identical.
+ */
+int abCompare(const std::string & dir, const AbConfig & config)
+{
+    if (config.repeat < 2)
+    {
+        std::cerr << "An A/B comparison needs at least 2 runs of each executable.\n";
+
+        return 1;
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/ab.txt"};
+
+    std::cout << "\nA/B comparison, A: " << config.a << ", B: " << config.b << ", " << config.repeat
+        << " interleaved runs each on " << config.size << " byte files.\n";
+    std::cout << "Speed is A time / B time, above 1 means B is faster, with a " << 100 * confidence << "% interval.\n";
+    std::cout << std::setw(10) << "Profile" << std::setw(8) << "Options" << std::setw(10) << "A secs" << std::setw(10) << "B secs"
+        << std::setw(8) << "Speed" << std::setw(18) << "Interval" << std::setw(9) << "Verdict" << "  Output\n";
+
+    int differences{};
+    int err{};
+    for (const auto & name : config.profiles)
+    {
+        const Profile * profile{findProfile(name)};
+        if (!profile)
+        {
+            std::cerr << "Unknown profile " << name << '\n';
+            err = 1;
+            continue;
+        }
+        if (generateFile(inputFileName, *profile, config.size))
+            return 1;
+
+        for (const auto & options : abOptions)
+        {
+            AbCase c{name, options};
+            if (runCase(config, inputFileName, dir, c))
+            {
+                err = 1;
+                continue;
+            }
+
+            double low{};
+            double high{};
+            const double speed{speedRatio(c, low, high)};
+            const char * verdict{low > 1 ? "faster" : high < 1 ? "slower" : "same"};
+            std::cout << std::setw(10) << name << std::setw(8) << options << std::fixed << std::setprecision(4)
+                << std::setw(10) << median(c.a) << std::setw(10) << median(c.b) << std::setprecision(3)
+                << std::setw(8) << speed << "  [" << std::setw(6) << low << ", " << std::setw(6) << high << ']'
+                << std::setw(9) << verdict << "  " << (c.identical ? "identical" : "DIFFERENT") << '\n';
+
+            if (!c.identical)
+                ++differences;
+        }
+    }
+    std::filesystem::remove(inputFileName);
+
+    if (differences)
+        std::cout << differences << " case(s) gave different output from A and B.\n";
+
+    return (err || differences) ? 1 : 0;
+}
+
+/**
+ * @brief Command line entry point for the A/B comparison.
+ *
+ *   test ab pathA pathB [--size S] [--repeat N] [--profile name]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "ab".
+ * @return int error value or 0 if no errors.
+ */
+int abCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    if (args.size() < 3)
+    {
+        std::cerr << "Two tfc executables are needed for an A/B comparison.\n";
+
+        return 1;
+    }
+
+    AbConfig config{args[1], args[2]};
+    int invalid{};
+    for (size_t i = 3; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], config.size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], config.repeat, 2);
+        else if (args[i] == "--profile" && value)
+            config.profiles.push_back(args[++i]);
+        else
+        {
+            std::cerr << "Unknown ab argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (config.profiles.empty())
+        config.profiles = { "all", "indent", "long" };
+
+    return abCompare(dir, config);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file    ab.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * A/B comparison of two tfc executables.
+ */
+
+#if !defined(_AB_H__20261017_1300__INCLUDED_)
+#define _AB_H__20261017_1300__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section A/B comparison interface.
+ *
+ * Both executables are run on the same generated corpus with the same
+ * option matrix. Their runs alternate A B, B A, A B ... so that drift in
+ * the machine affects both equally, and the speed ratio of each case is
+ * given with a paired bootstrap confidence interval.
+ */
+
+struct AbConfig
+{
+    std::string a;                          // Baseline executable.
+    std::string b;                          // Candidate executable.
+    size_t size{16 << 20};
+    int repeat{10};
+    std::vector<std::string> profiles{};
+};
+
+extern int abCompare(const std::string & dir, const AbConfig & config);
+extern int abCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_AB_H__20261017_1300__INCLUDED_)
@@ -0,0 +1,157 @@
+/**
+ * @file    accounting.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Per-process I/O accounting of tfc invocations.
+ *
+ * rchar and wchar include the bytes the dynamic loader reads from shared
+ * libraries, so only files of at least 'minimumSize' bytes are judged.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <mutex>
+#include <filesystem>
+
+#include "accounting.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// Files smaller than this are too small for the averages to be meaningful.
+static const size_t minimumSize{64 << 10};
+
+// Reads or writes averaging fewer bytes per system call than this are
+// flagged as unbuffered.
+static const double minimumAverage{1024};
+
+static std::vector<IoReport> reports{};
+static std::mutex reportMutex{};
+
+static size_t fileSize(const std::string & fileName)
+{
+    std::error_code ec{};
+    const auto size{std::filesystem::file_size(fileName, ec)};
+
+    return ec ? 0 : size;
+}
+
+
+/**
+ * @section I/O accounting implementation.
+ *
+ */
+
+/**
+ * @brief Compare the I/O counters of a tfc run with the sizes of the files
+ * it was given.
+ *
+ * @param command line that was executed.
+ * @param usage of the child process.
+ * @return IoReport the analysis.
+ */
+IoReport analyseIo(const std::string & command, const Usage & usage)
+{
+    IoReport report{command, 0, 0, usage};
+
+    std::istringstream is{command};
+    for (std::string arg; is >> arg; )
+    {
+        std::string fileName{};
+        if ((arg == "-i" || arg == "--input") && is >> fileName)
+            report.input = fileSize(fileName);
+        else if ((arg == "-o" || arg == "--output") && is >> fileName)
+            report.output = fileSize(fileName);
+        else if ((arg == "-r" || arg == "--replace") && is >> fileName)
+            report.input = report.output = fileSize(fileName);
+    }
+
+    if (report.input)
+        report.readAmplification = static_cast<double>(usage.rchar) / report.input;
+    if (report.output)
+        report.writeAmplification = static_cast<double>(usage.wchar) / report.output;
+    if (usage.syscr)
+        report.averageRead = static_cast<double>(usage.rchar) / usage.syscr;
+    if (usage.syscw)
+        report.averageWrite = static_cast<double>(usage.wchar) / usage.syscw;
+
+    report.flagged = ((report.input >= minimumSize) && (report.averageRead < minimumAverage)) ||
+        ((report.output >= minimumSize) && (report.averageWrite < minimumAverage));
+
+    return report;
+}
+
+/**
+ * @brief Analyse and keep the I/O counters of a run for the summary.
+ *
+ * @param command line that was executed.
+ * @param usage of the child process.
+ */
+void recordIo(const std::string & command, const Usage & usage)
+{
+    const IoReport report{analyseIo(command, usage)};
+
+    std::lock_guard<std::mutex> lock{reportMutex};
+    reports.push_back(report);
+}
+
+/**
+ * @brief Output the I/O accounting of every run on a file large enough to
+ * judge, marking runs with small reads or writes.
+ *
+ * @return int the number of flagged runs.
+ */
+int outputIoSummary(void)
+{
+    std::lock_guard<std::mutex> lock{reportMutex};
+
+    int flagged{};
+    size_t judged{};
+    for (const auto & report : reports)
+    {
+        if ((report.input < minimumSize) && (report.output < minimumSize))
+            continue;
+
+        if (!judged++)
+        {
+            std::cout << "\nI/O accounting of runs on files of " << minimumSize << " bytes or more:\n";
+            std::cout << std::setw(14) << "Input" << std::setw(14) << "Output" << std::setw(9) << "Read x" << std::setw(9) << "Write x"
+                << std::setw(11) << "B/read" << std::setw(11) << "B/write" << std::setw(14) << "Disk read" << std::setw(14) << "Disk write"
+                << "  Command\n";
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+            << std::setw(14) << report.input << std::setw(14) << report.output
+            << std::setw(9) << report.readAmplification << std::setw(9) << report.writeAmplification
+            << std::setprecision(0) << std::setw(11) << report.averageRead << std::setw(11) << report.averageWrite
+            << std::setw(14) << report.usage.readBytes << std::setw(14) << report.usage.writeBytes
+            << "  " << report.command << (report.flagged ? "  <- small reads or writes" : "") << '\n';
+
+        if (report.flagged)
+            ++flagged;
+    }
+
+    if (flagged)
+        std::cout << flagged << " run(s) used reads or writes averaging under " << minimumAverage << " bytes.\n";
+
+    return flagged;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file    accounting.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Per-process I/O accounting of tfc invocations.
+ */
+
+#if !defined(_ACCOUNTING_H__20261017_1130__INCLUDED_)
+#define _ACCOUNTING_H__20261017_1130__INCLUDED_
+
+#include <string>
+
+#include "spawn.h"
+
+
+/**
+ * @section I/O accounting interface.
+ *
+ * The /proc/<pid>/io counters collected by spawn() are compared with the
+ * sizes of the files named by -i, -o and -r to give the read and write
+ * amplification and the average size of each read and write system call.
+ */
+
+struct IoReport
+{
+    std::string command;
+    size_t input{};             // Input file size in bytes, 0 if unknown.
+    size_t output{};            // Output file size in bytes, 0 if unknown.
+    Usage usage{};
+    double readAmplification{};
+    double writeAmplification{};
+    double averageRead{};       // Bytes per read system call.
+    double averageWrite{};      // Bytes per write system call.
+    bool flagged{};             // Small reads or writes on a large file.
+};
+
+extern IoReport analyseIo(const std::string & command, const Usage & usage);
+extern void recordIo(const std::string & command, const Usage & usage);
+extern int outputIoSummary(void);
+
+
+#endif // !defined(_ACCOUNTING_H__20261017_1130__INCLUDED_)
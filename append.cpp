@@ -0,0 +1,377 @@
+/**
+ * @file    append.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Append aware summary verification of growing log files.
+ *
+ * The log must not be appended to while tfc is summarising it, otherwise
+ * tfc and the checkpoint may see different lengths.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "results.h"
+#include "append.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const size_t blockSize{1 << 20};
+
+// Bytes at the start of the file and before the checkpoint offset that must
+// be unchanged for the file to be treated as appended to.
+static const size_t hashWindow{4096};
+
+/**
+ * @brief FNV-1a hash of a buffer.
+ */
+static uint64_t hashBytes(const char * data, size_t length)
+{
+    uint64_t hash{0xCBF29CE484222325ULL};
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Hash the bytes of a file in the windows at its start and before
+ * an offset.
+ *
+ * @return int error value or 0 if no errors.
+ */
+static int hashBefore(const std::string & fileName, size_t offset, uint64_t & hash)
+{
+    const size_t length{std::min(offset, hashWindow)};
+    std::vector<char> buffer(2 * length);
+    std::ifstream is{fileName, std::ios::binary};
+    if (!is || !is.read(buffer.data(), length) || !is.seekg(offset - length) || !is.read(buffer.data() + length, length))
+        return 1;
+
+    hash = hashBytes(buffer.data(), buffer.size());
+
+    return 0;
+}
+
+/**
+ * @brief Append a byte range of one file to another a block at a time.
+ *
+ * @return int error value or 0 if no errors.
+ */
+static int appendRange(const std::string & fromFileName, size_t offset, size_t length, const std::string & toFileName)
+{
+    std::ifstream is{fromFileName, std::ios::binary};
+    std::ofstream os{toFileName, std::ios::binary|std::ios::app};
+    if (!is || !is.seekg(offset) || !os)
+        return 1;
+
+    std::vector<char> buffer(std::min(length, blockSize));
+    while (length)
+    {
+        const size_t size{std::min(length, buffer.size())};
+        if (!is.read(buffer.data(), size) || !os.write(buffer.data(), size))
+            return 1;
+        length -= size;
+    }
+
+    return os.flush() ? 0 : 1;
+}
+
+
+/**
+ * @section append checkpoint implementation.
+ *
+ */
+
+/**
+ * @brief Load a checkpoint.
+ *
+ * @param checkpointFileName of the checkpoint.
+ * @param checkpoint set to the loaded checkpoint, or a fresh one on error.
+ * @return int error value or 0 if no errors.
+ */
+int loadCheckpoint(const std::string & checkpointFileName, Checkpoint & checkpoint)
+{
+    checkpoint = Checkpoint{};
+    std::ifstream is{checkpointFileName};
+    if (!is)
+        return 1;
+
+    Checkpoint loaded{};
+    if (!(is >> loaded.offset >> loaded.hash) || !loaded.counter.load(is))
+        return 1;
+
+    checkpoint = loaded;
+
+    return 0;
+}
+
+/**
+ * @brief Save a checkpoint, replacing any previous one atomically.
+ *
+ * @param checkpointFileName of the checkpoint.
+ * @param checkpoint to save.
+ * @return int error value or 0 if no errors.
+ */
+int saveCheckpoint(const std::string & checkpointFileName, const Checkpoint & checkpoint)
+{
+    const std::string tempFileName{checkpointFileName + ".tmp"};
+    {
+        std::ofstream os{tempFileName};
+        if (!os)
+            return 1;
+
+        os << checkpoint.offset << ' ' << checkpoint.hash << '\n';
+        checkpoint.counter.save(os);
+        if (!os.flush())
+            return 1;
+    }
+
+    std::error_code ec{};
+    std::filesystem::rename(tempFileName, checkpointFileName, ec);
+
+    return ec ? 1 : 0;
+}
+
+/**
+ * @brief Bring a checkpoint up to the current end of a file, counting only
+ * the appended bytes unless the file has been rewritten.
+ *
+ * @param fileName of the file.
+ * @param checkpoint to update.
+ * @param scanned set to the number of bytes counted.
+ * @return int error value or 0 if no errors.
+ */
+int updateCheckpoint(const std::string & fileName, Checkpoint & checkpoint, size_t & scanned)
+{
+    scanned = 0;
+    std::error_code ec{};
+    const size_t size = std::filesystem::file_size(fileName, ec);
+    if (ec)
+        return 1;
+
+    uint64_t hash{};
+    if ((size < checkpoint.offset) || hashBefore(fileName, checkpoint.offset, hash) || (hash != checkpoint.hash))
+        checkpoint = Checkpoint{};
+
+    std::ifstream is{fileName, std::ios::binary};
+    if (!is || !is.seekg(checkpoint.offset))
+        return 1;
+
+    std::vector<char> buffer(blockSize);
+    while (is)
+    {
+        is.read(buffer.data(), buffer.size());
+        const size_t length = is.gcount();
+        checkpoint.counter.add(buffer.data(), length);
+        checkpoint.offset += length;
+        scanned += length;
+    }
+    if (is.bad())
+        return 1;
+
+    return hashBefore(fileName, checkpoint.offset, checkpoint.hash);
+}
+
+/**
+ * @brief Check the tfc summary of a file against its checkpoint, counting
+ * only what has been appended since the last check.
+ *
+ * @param fileName of the file to check.
+ * @param checkpointFileName of the checkpoint, created if missing.
+ * @param outputFileName for the tfc summary.
+ * @param scanned set to the number of bytes counted.
+ * @return int error value or 0 if the summary matched.
+ */
+int appendCheck(const std::string & fileName, const std::string & checkpointFileName, const std::string & outputFileName, size_t & scanned)
+{
+    Checkpoint checkpoint{};
+    loadCheckpoint(checkpointFileName, checkpoint);
+
+    Stopwatch stopwatch{};
+    if (updateCheckpoint(fileName, checkpoint, scanned))
+    {
+        std::cerr << "Unable to read " << fileName << '\n';
+
+        return 1;
+    }
+    const double kernel{stopwatch.elapsed()};
+
+    Usage usage{};
+    const int err{spawn(tfcPath + " -x -i " + fileName + " -o " + outputFileName, usage) ||
+        verifySummary(fileName, outputFileName, checkpoint.counter.total())};
+
+    std::cout << std::setw(14) << checkpoint.offset << std::setw(14) << scanned << std::fixed << std::setprecision(4)
+        << std::setw(10) << kernel << std::setw(10) << usage.elapsed << "  " << (err ? "DIFFERENT" : "matched") << '\n';
+
+    if (!err && saveCheckpoint(checkpointFileName, checkpoint))
+    {
+        std::cerr << "Unable to save checkpoint " << checkpointFileName << '\n';
+
+        return 1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Grow a log in steps that split lines and EOLs at arbitrary bytes,
+ * checking the summary after each, then rewrite the start of the log and
+ * check the rewrite is detected.
+ *
+ * @param dir working directory for the generated files.
+ * @param size final size of the log in bytes.
+ * @param steps number of appends.
+ * @return int error value or 0 if every check matched, each appended byte
+ * was counted once and the rewrite was counted from the start.
+ */
+int appendSimulate(const std::string & dir, size_t size, int steps)
+{
+    std::filesystem::create_directories(dir);
+    const std::string sourceFileName{dir + "/appendSource.txt"};
+    const std::string logFileName{dir + "/append.log"};
+    const std::string checkpointFileName{dir + "/append.checkpoint"};
+    const std::string outputFileName{dir + "/appendOut.txt"};
+    if (generateFile(sourceFileName, *findProfile("all"), size))
+        return 1;
+
+    std::filesystem::remove(logFileName);
+    std::filesystem::remove(checkpointFileName);
+    std::ofstream{logFileName, std::ios::binary};
+
+    const size_t total = std::filesystem::file_size(sourceFileName);
+    std::cout << std::setw(14) << "Bytes" << std::setw(14) << "Scanned" << std::setw(10) << "Kernel" << std::setw(10) << "tfc" << "  Summary\n";
+
+    int err{};
+    size_t counted{};
+    size_t offset{};
+    for (int step = 1; step <= steps && !err; ++step)
+    {
+        // Step ends are offset by an odd amount to land mid-line.
+        const size_t end{step == steps ? total : std::min(total, total * step / steps + 7 * step)};
+        size_t scanned{};
+        err |= appendRange(sourceFileName, offset, end - offset, logFileName);
+        err |= appendCheck(logFileName, checkpointFileName, outputFileName, scanned);
+        counted += scanned;
+        offset = end;
+    }
+    if (!err && (counted != total))
+    {
+        std::cout << "Counted " << counted << " appended bytes, " << total << " expected.\n";
+        err = 1;
+    }
+
+    if (!err)
+    {
+        size_t scanned{};
+        if (std::fstream fs{logFileName, std::ios::binary|std::ios::in|std::ios::out})
+            fs.put(fs.peek() == '\t' ? ' ' : '\t');
+        err |= appendCheck(logFileName, checkpointFileName, outputFileName, scanned);
+        if (!err && (scanned != total))
+        {
+            std::cout << "Rewritten log was not counted again from the start.\n";
+            err = 1;
+        }
+    }
+
+    std::filesystem::remove(sourceFileName);
+    std::filesystem::remove(logFileName);
+    std::filesystem::remove(checkpointFileName);
+    std::filesystem::remove(outputFileName);
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the append aware checks.
+ *
+ *   test append file [--checkpoint path]
+ *   test append --simulate [--size S] [--steps N]
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "append".
+ * @return int error value or 0 if no errors.
+ */
+int appendCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    bool simulate{};
+    size_t size{64 << 20};
+    int steps{8};
+    std::string fileName{};
+    std::string checkpointFileName{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--simulate")
+            simulate = true;
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--steps" && value)
+            invalid |= parseInt(args[++i], steps, 1);
+        else if (args[i] == "--checkpoint" && value)
+            checkpointFileName = args[++i];
+        else if (fileName.empty())
+            fileName = args[i];
+        else
+        {
+            std::cerr << "Unknown append argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    if (simulate)
+    {
+        std::cout << "\nSimulated log of " << size << " bytes appended in " << steps << " steps.\n";
+
+        return appendSimulate(dir, size, steps);
+    }
+
+    if (fileName.empty())
+    {
+        std::cerr << "No file to check.\n";
+
+        return 1;
+    }
+    if (checkpointFileName.empty())
+        checkpointFileName = fileName + ".checkpoint";
+
+    std::filesystem::create_directories(dir);
+    std::cout << std::setw(14) << "Bytes" << std::setw(14) << "Scanned" << std::setw(10) << "Kernel" << std::setw(10) << "tfc" << "  Summary\n";
+    size_t scanned{};
+    const int err{appendCheck(fileName, checkpointFileName, dir + "/appendOut.txt", scanned)};
+    std::filesystem::remove(dir + "/appendOut.txt");
+
+    return err;
+}
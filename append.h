@@ -0,0 +1,60 @@
+/**
+ * @file    append.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Append aware summary verification of growing log files.
+ */
+
+#if !defined(_APPEND_H__20261017_1730__INCLUDED_)
+#define _APPEND_H__20261017_1730__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "summary.h"
+
+
+/**
+ * @section append checkpoint interface.
+ *
+ * A Checkpoint holds the summary kernel state at a byte offset of a file,
+ * with a hash of the bytes at the start of the file and before the offset.
+ * When the file grows only the new bytes are counted. If the file has
+ * shrunk or the hashed bytes have changed, the file was rewritten rather
+ * than appended to and it is counted again from the start.
+ */
+
+struct Checkpoint
+{
+    size_t offset{};        // Bytes of the file counted.
+    uint64_t hash{};        // Hash of the bytes before the offset.
+    SummaryCounter counter{};
+};
+
+extern int loadCheckpoint(const std::string & checkpointFileName, Checkpoint & checkpoint);
+extern int saveCheckpoint(const std::string & checkpointFileName, const Checkpoint & checkpoint);
+extern int updateCheckpoint(const std::string & fileName, Checkpoint & checkpoint, size_t & scanned);
+
+extern int appendCheck(const std::string & fileName, const std::string & checkpointFileName, const std::string & outputFileName, size_t & scanned);
+extern int appendSimulate(const std::string & dir, size_t size, int steps);
+extern int appendCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_APPEND_H__20261017_1730__INCLUDED_)
@@ -0,0 +1,400 @@
+/**
+ * @file    batch.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Batch summary verification of every file in a directory tree, as used
+ * to audit whole repositories.
+ *
+ * Walking, reading and counting overlap, with bounded queues between the
+ * stages so that memory use stays flat however large the tree is.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "results.h"
+#include "trace.h"
+#include "summary.h"
+#include "batch.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// Files larger than this are counted from disk by the checker rather than
+// held in the file queue.
+static const size_t loadLimit{16 << 20};
+
+struct BatchFile
+{
+    std::string path;
+    std::string data;
+    bool loaded{};
+};
+
+/**
+ * @brief A fixed capacity queue between two pipeline stages. push() blocks
+ * while the queue is full and pop() while it is empty, and each counts the
+ * times it had to wait.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity{std::max<size_t>(capacity, 1)} {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        if (items.size() >= capacity)
+        {
+            ++fullStalls;
+            notFull.wait(lock, [this]() { return items.size() < capacity; });
+        }
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+    }
+
+    /**
+     * @return bool false once the queue is closed and empty.
+     */
+    bool pop(T & item)
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        if (items.empty() && !closed)
+        {
+            ++emptyStalls;
+            notEmpty.wait(lock, [this]() { return !items.empty() || closed; });
+        }
+        if (items.empty())
+            return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+
+        return true;
+    }
+
+    void close(void)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        closed = true;
+        notEmpty.notify_all();
+    }
+
+    size_t fullStalls{};
+    size_t emptyStalls{};
+
+private:
+    const size_t capacity;
+    std::deque<T> items{};
+    bool closed{};
+    std::mutex mutex{};
+    std::condition_variable notFull{};
+    std::condition_variable notEmpty{};
+
+};
+
+/**
+ * @brief Quote a path for the shell, so trees with spaces or quotes in
+ * their names can be audited.
+ */
+static std::string shellQuote(const std::string & path)
+{
+    std::string quoted{"'"};
+    for (const auto c : path)
+        if (c == '\'')
+            quoted += "'\\''";
+        else
+            quoted += c;
+
+    return quoted + '\'';
+}
+
+static bool readWhole(const std::string & fileName, std::string & data)
+{
+    std::ifstream is{fileName, std::ios::binary|std::ios::in};
+    if (!is)
+        return false;
+
+    std::ostringstream os{};
+    os << is.rdbuf();
+    data = os.str();
+
+    return !is.bad();
+}
+
+
+/**
+ * @section batch summary implementation.
+ *
+ */
+
+/**
+ * @brief Generate a tree of files of every pathological shape, spread
+ * across nested directories, each with its own seed.
+ *
+ * @param root directory of the tree, replaced if it exists.
+ * @param files number of files to generate.
+ * @param size of each file in bytes.
+ * @return int error value or 0 if no errors.
+ */
+int batchGenerate(const std::string & root, size_t files, size_t size)
+{
+    std::error_code ec{};
+    std::filesystem::remove_all(root, ec);
+
+    const auto shapes{shapeNames()};
+    for (size_t i = 0; i < files; ++i)
+    {
+        const std::string dir{root + "/d" + std::to_string(i % 7) + "/e" + std::to_string(i % 3)};
+        std::filesystem::create_directories(dir);
+
+        const std::string & shape{shapes[i % shapes.size()]};
+        if (generateShape(dir + "/" + shape + std::to_string(i) + ".txt", *findShape(shape), size, i + 1))
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Check the tfc summary of every regular file in a tree against the
+ * in-harness kernel. The tree is walked on one thread while reader threads
+ * load the files it finds and checker threads count them and run tfc.
+ *
+ * @param root directory of the tree to check.
+ * @param dir working directory for the tfc reports.
+ * @param threads number of checker threads, 0 for one per hardware thread.
+ * Half as many reader threads are used.
+ * @param capacity of each queue between the stages.
+ * @param report set to the totals, timings and stalls.
+ * @return int the number of files that did not match or could not be checked.
+ */
+int batchCheck(const std::string & root, const std::string & dir, unsigned threads, size_t capacity, BatchReport & report)
+{
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned readers{std::max(1u, threads / 2)};
+
+    std::filesystem::create_directories(dir);
+    report = BatchReport{};
+
+    BoundedQueue<std::string> paths{capacity};
+    BoundedQueue<BatchFile> files{capacity};
+    std::mutex reportMutex{};
+    auto fail = [&](const std::string & path, bool mismatch)
+    {
+        std::lock_guard<std::mutex> lock{reportMutex};
+        ++(mismatch ? report.mismatches : report.errors);
+        report.failed.push_back(path);
+    };
+
+    // The checkers' tfc runs are recorded as one execute phase, from the
+    // first spawn to the last exit, in seconds since 'clock' started.
+    double firstSpawn{std::numeric_limits<double>::max()};
+    double lastExit{};
+    size_t executeBytes{};
+
+    Stopwatch clock{};
+    std::thread walker{[&]()
+    {
+        traceThreadName("batch walker");
+        std::error_code ec{};
+        for (std::filesystem::recursive_directory_iterator it{root, std::filesystem::directory_options::skip_permission_denied, ec}, end{};
+            !ec && it != end; it.increment(ec))
+            if (it->is_regular_file(ec))
+                paths.push(it->path().string());
+        if (ec)
+            fail(root, false);
+        paths.close();
+    }};
+
+    std::atomic<unsigned> reading{readers};
+    std::vector<std::thread> workers{};
+    for (unsigned r = 0; r < readers; ++r)
+        workers.emplace_back([&, r]()
+        {
+            traceThreadName("batch reader " + std::to_string(r));
+            for (std::string path; paths.pop(path); )
+            {
+                std::error_code ec{};
+                BatchFile file{path, {}, std::filesystem::file_size(path, ec) <= loadLimit};
+                if (ec || (file.loaded && !readWhole(path, file.data)))
+                    fail(path, false);
+                else
+                    files.push(std::move(file));
+            }
+            if (--reading == 0)
+                files.close();
+        });
+
+    for (unsigned c = 0; c < threads; ++c)
+        workers.emplace_back([&, c]()
+        {
+            traceThreadName("batch checker " + std::to_string(c));
+            suppressPhases();
+            const std::string outputFileName{dir + "/batchOut" + std::to_string(c) + ".txt"};
+            size_t checked{};
+            size_t bytes{};
+            double count{};
+            double tfc{};
+            double spawned{std::numeric_limits<double>::max()};
+            double exited{};
+            size_t io{};
+            for (BatchFile file; files.pop(file); )
+            {
+                Summary expected{};
+                Stopwatch countClock{};
+                int err{};
+                if (file.loaded)
+                {
+                    SummaryCounter counter{};
+                    counter.add(file.data.data(), file.data.size());
+                    expected = counter.finish();
+                }
+                else
+                    err = summariseFile(file.path, expected);
+                count += countClock.elapsed();
+
+                Usage usage{};
+                spawned = std::min(spawned, clock.elapsed());
+                err |= spawn(tfcPath + " -x -i " + shellQuote(file.path) + " -o " + outputFileName, usage);
+                exited = clock.elapsed();
+                tfc += usage.elapsed;
+                io += usage.rchar + usage.wchar;
+
+                ++checked;
+                std::error_code ec{};
+                bytes += file.loaded ? file.data.size() : std::filesystem::file_size(file.path, ec);
+                if (err)
+                    fail(file.path, false);
+                else if (verifySummary(file.path, outputFileName, expected))
+                    fail(file.path, true);
+            }
+            std::filesystem::remove(outputFileName);
+
+            std::lock_guard<std::mutex> lock{reportMutex};
+            report.files += checked;
+            report.bytes += bytes;
+            report.count += count;
+            report.tfc += tfc;
+            firstSpawn = std::min(firstSpawn, spawned);
+            lastExit = std::max(lastExit, exited);
+            executeBytes += io;
+        });
+
+    walker.join();
+    for (auto & worker : workers)
+        worker.join();
+
+    report.elapsed = clock.elapsed();
+    if (report.files)
+        recordPhase(EXECUTE, lastExit - firstSpawn, executeBytes);
+    report.pathStalls = paths.fullStalls;
+    report.fileStalls = files.fullStalls;
+    report.idleCheckers = files.emptyStalls;
+    std::sort(report.failed.begin(), report.failed.end());
+
+    return report.mismatches + report.errors;
+}
+
+/**
+ * @brief Command line entry point for the batch summary check. With no
+ * tree given, a generated tree is checked.
+ *
+ *   test batch [root] [--threads N] [--queue N] [--files N] [--size S]
+ *
+ * @param dir working directory for the generated tree and tfc reports.
+ * @param args command line arguments, starting with "batch".
+ * @return int error value or 0 if no errors.
+ */
+int batchCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    std::string root{};
+    unsigned threads{};
+    size_t capacity{64};
+    size_t files{1000};
+    size_t size{16 << 10};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--threads" && value)
+            invalid |= parseInt(args[++i], threads);
+        else if (args[i] == "--queue" && value)
+            invalid |= parseInt(args[++i], capacity, 1);
+        else if (args[i] == "--files" && value)
+            invalid |= parseInt(args[++i], files, 1);
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (root.empty() && args[i][0] != '-')
+            root = args[i];
+        else
+        {
+            std::cerr << "Unknown batch argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    const bool generated{root.empty()};
+    if (generated)
+    {
+        root = dir + "/batchTree";
+        std::cout << "\nGenerating " << files << " files of " << size << " bytes in " << root << '\n';
+        if (batchGenerate(root, files, size))
+            return 1;
+    }
+
+    BatchReport report{};
+    const int failed{batchCheck(root, dir, threads, capacity, report)};
+    if (generated)
+        std::filesystem::remove_all(root);
+
+    const double perFile{report.files ? 1000.0 / report.files : 0};
+    std::cout << "\nChecked " << report.files << " files, " << report.bytes << " bytes, in " << std::fixed << std::setprecision(2)
+        << report.elapsed << " seconds: " << std::setprecision(1) << (report.elapsed ? report.files / report.elapsed : 0) << " files/s, "
+        << (report.elapsed ? report.bytes / static_cast<double>(MiB) / report.elapsed : 0) << " MiB/s.\n";
+    std::cout << "Per file: " << std::setprecision(3) << report.count * perFile << " ms in the summary kernel, "
+        << report.tfc * perFile << " ms running tfc.\n";
+    std::cout << "Stalls: walker " << report.pathStalls << " (readers behind), readers " << report.fileStalls
+        << " (checkers behind), checkers " << report.idleCheckers << " (readers or walker behind).\n";
+    for (const auto & path : report.failed)
+        std::cout << "  " << path << '\n';
+    std::cout << report.mismatches << " mismatches, " << report.errors << " errors.\n";
+
+    return failed ? 1 : 0;
+}
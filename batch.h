@@ -0,0 +1,62 @@
+/**
+ * @file    batch.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Batch summary verification of every file in a directory tree.
+ */
+
+#if !defined(_BATCH_H__20261017_1830__INCLUDED_)
+#define _BATCH_H__20261017_1830__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section batch summary interface.
+ *
+ * The files of a tree are checked in three overlapping stages joined by
+ * bounded queues: one thread walks the tree, reader threads load each file
+ * and checker threads count it with the summary kernel and compare the
+ * result with 'tfc -x'. A stage that keeps finding its output queue full
+ * is waiting on the stage after it, so the stall counts show whether the
+ * walk, the reads or the per-file checks limit the rate.
+ */
+
+struct BatchReport
+{
+    size_t files{};
+    size_t bytes{};
+    size_t mismatches{};    // Files whose tfc summary did not match.
+    size_t errors{};        // Files that could not be read or summarised by tfc.
+    double elapsed{};       // Wall clock seconds for the whole tree.
+    double count{};         // Checker seconds in the summary kernel.
+    double tfc{};           // Checker seconds running tfc.
+    size_t pathStalls{};    // Times the walker found the path queue full.
+    size_t fileStalls{};    // Times a reader found the file queue full.
+    size_t idleCheckers{};  // Times a checker found the file queue empty.
+    std::vector<std::string> failed{};
+};
+
+extern int batchGenerate(const std::string & root, size_t files, size_t size);
+extern int batchCheck(const std::string & root, const std::string & dir, unsigned threads, size_t capacity, BatchReport & report);
+extern int batchCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_BATCH_H__20261017_1830__INCLUDED_)
@@ -0,0 +1,768 @@
+/**
+ * @file    bench.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmark and resource usage checks for the 'tfc' utility.
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "history.h"
+#include "accounting.h"
+#include "noise.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// Peak RSS may grow by at most this fraction of the growth in input size.
+static const double maxGrowth{0.05};
+
+/**
+ * @brief Convert a size such as "512", "64K", "256M" or "4G" to bytes.
+ *
+ * @param text size with optional binary suffix.
+ * @return size_t number of bytes, or 0 if the text is not a valid size,
+ * including a negative size or one too large for size_t.
+ */
+size_t parseSize(const std::string & text)
+{
+    // std::stoull accepts a minus sign and negates the value modulo 2^64.
+    if (text.find('-') != std::string::npos)
+        return 0;
+
+    size_t pos{};
+    size_t value{};
+    try
+    {
+        value = std::stoull(text, &pos);
+    }
+    catch (...)
+    {
+        return 0;
+    }
+
+    const std::string suffix{text.substr(pos)};
+    int shift{};
+    if (suffix == "K" || suffix == "k")
+        shift = 10;
+    else if (suffix == "M" || suffix == "m")
+        shift = 20;
+    else if (suffix == "G" || suffix == "g")
+        shift = 30;
+    else if (!suffix.empty())
+        return 0;
+
+    return (value > (std::numeric_limits<size_t>::max() >> shift)) ? 0 : value << shift;
+}
+
+/**
+ * @brief Convert a command line size to bytes, reporting a size that is
+ * not valid or is 0.
+ *
+ * @param text size with optional binary suffix.
+ * @param size set to the number of bytes if valid.
+ * @return int error value or 0 if the size is valid.
+ */
+int parseSize(const std::string & text, size_t & size)
+{
+    const size_t parsed{parseSize(text)};
+    if (!parsed)
+    {
+        std::cerr << "Invalid size " << text << '\n';
+
+        return 1;
+    }
+    size = parsed;
+
+    return 0;
+}
+
+/**
+ * @brief Convert a command line integer, reporting text that is not a
+ * whole number in the range.
+ *
+ * @param text the integer.
+ * @param value set to the integer if valid.
+ * @param min smallest valid value.
+ * @param max largest valid value.
+ * @return int error value or 0 if the integer is valid.
+ */
+int parseInt(const std::string & text, long long & value, long long min, long long max)
+{
+    size_t pos{};
+    long long parsed{};
+    try
+    {
+        parsed = std::stoll(text, &pos);
+    }
+    catch (...)
+    {
+        pos = 0;
+    }
+    if (!pos || (pos != text.size()) || (parsed < min) || (parsed > max))
+    {
+        std::cerr << "Invalid number " << text << ", expected a whole number from " << min << " to " << max << '\n';
+
+        return 1;
+    }
+    value = parsed;
+
+    return 0;
+}
+
+/**
+ * @brief Convert a command line number, reporting text that is not a
+ * number of at least 'min'.
+ *
+ * @param text the number.
+ * @param value set to the number if valid.
+ * @param min smallest valid value.
+ * @return int error value or 0 if the number is valid.
+ */
+int parseDouble(const std::string & text, double & value, double min)
+{
+    size_t pos{};
+    double parsed{};
+    try
+    {
+        parsed = std::stod(text, &pos);
+    }
+    catch (...)
+    {
+        pos = 0;
+    }
+    if (!pos || (pos != text.size()) || !(parsed >= min))
+    {
+        std::cerr << "Invalid number " << text << ", expected at least " << min << '\n';
+
+        return 1;
+    }
+    value = parsed;
+
+    return 0;
+}
+
+/**
+ * @brief Get the median of a set of values.
+ *
+ * @param values to take the median of.
+ * @return double the median, the mean of the middle two of an even number
+ * of values, or 0 if there are none.
+ */
+double median(std::vector<double> values)
+{
+    if (values.empty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    const size_t mid{values.size() / 2};
+
+    return (values.size() & 1) ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+}
+
+/**
+ * @brief Compare two files a block at a time.
+ *
+ * @param lhs name of the first file.
+ * @param rhs name of the second file.
+ * @return true if both files could be read and their contents match.
+ */
+bool sameContent(const std::string & lhs, const std::string & rhs)
+{
+    std::ifstream a{lhs, std::ios::binary};
+    std::ifstream b{rhs, std::ios::binary};
+    if (!a || !b)
+        return false;
+
+    std::vector<char> x(MiB);
+    std::vector<char> y(MiB);
+    for (;;)
+    {
+        a.read(x.data(), x.size());
+        b.read(y.data(), y.size());
+        if (a.gcount() != b.gcount())
+            return false;
+        if (!std::equal(x.begin(), x.begin() + a.gcount(), y.begin()))
+            return false;
+        if (!a)
+            return !b;
+    }
+}
+
+/**
+ * @brief Least squares gradient of y against x.
+ */
+double slope(const std::vector<double> & x, const std::vector<double> & y)
+{
+    const size_t n{x.size()};
+    if (n < 2)
+        return 0;
+
+    double sx{}, sy{}, sxx{}, sxy{};
+    for (size_t i = 0; i < n; ++i)
+    {
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        sxy += x[i] * y[i];
+    }
+
+    const double d{n * sxx - sx * sx};
+
+    return d ? (n * sxy - sx * sy) / d : 0;
+}
+
+static void removeFile(const std::string & fileName)
+{
+    std::filesystem::remove(fileName);
+}
+
+/**
+ * @brief Drop a file from the page cache. Dirty pages cannot be dropped so
+ * the file is flushed first. No privileges are needed, but pages mapped or
+ * locked by another process stay cached.
+ *
+ * @param fileName of the file to evict.
+ * @return int error value or 0 if no errors.
+ */
+static int evictFile(const std::string & fileName)
+{
+    const int fd{open(fileName.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return 1;
+
+    const bool failed{(fsync(fd) < 0) || (posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0)};
+    close(fd);
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * @brief Get the fraction of a file's pages that are in the page cache.
+ *
+ * @param fileName of the file to check.
+ * @return double fraction cached, or -1 if it could not be determined.
+ */
+static double cachedFraction(const std::string & fileName)
+{
+    const int fd{open(fileName.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return -1;
+
+    const off_t size{lseek(fd, 0, SEEK_END)};
+    void * map{size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED};
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    const long pageSize{sysconf(_SC_PAGESIZE)};
+    std::vector<unsigned char> pages((size + pageSize - 1) / pageSize);
+    double fraction{-1};
+    if (mincore(map, size, pages.data()) == 0)
+        fraction = std::count_if(pages.begin(), pages.end(), [](unsigned char page) { return page & 1; })
+            / static_cast<double>(pages.size());
+    munmap(map, size);
+
+    return fraction;
+}
+
+
+/**
+ * @section memory ceiling checks.
+ *
+ */
+
+/**
+ * @brief Run tfc on a generated file that is larger than the memory limit
+ * imposed on it. A tfc that streams succeeds, one that buffers the whole
+ * file is refused the memory and fails.
+ *
+ * @param dir working directory for the generated files.
+ * @param options tfc options to use.
+ * @param size of the generated input in bytes.
+ * @param limit on the address space of tfc in bytes.
+ * @return int error value or 0 if no errors.
+ */
+int memoryCeiling(const std::string & dir, const std::string & options, size_t size, size_t limit)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/ceiling.txt"};
+    const std::string outputFileName{dir + "/ceilingOut.txt"};
+
+    if (generateFile(inputFileName, *findProfile("all"), size))
+        return 1;
+
+    Usage usage{};
+    const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+    const int status{spawn(command, usage, Limits{limit})};
+
+    std::cout << "  " << command << " : status " << status << ", " << usage.maxRss << " KiB peak RSS under a "
+        << (limit / MiB) << " MiB limit\n";
+
+    removeFile(inputFileName);
+    removeFile(outputFileName);
+
+    return status;
+}
+
+/**
+ * @brief Run tfc over geometrically growing inputs under a memory limit and
+ * check that peak RSS does not grow with the input size.
+ *
+ * @param dir working directory for the generated files.
+ * @param from smallest input size in bytes.
+ * @param to largest input size in bytes.
+ * @param limit on the address space of tfc in bytes, 0 for no limit.
+ * @return int error value or 0 if no errors.
+ */
+int memorySweep(const std::string & dir, size_t from, size_t to, size_t limit)
+{
+    const std::vector<std::string> optionSets{ "-x", "-s -u", "-t -d" };
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/sweep.txt"};
+    const std::string outputFileName{dir + "/sweepOut.txt"};
+
+    std::vector<double> sizes{};
+    std::vector<std::vector<double>> rss(optionSets.size());
+    int err{};
+
+    std::cout << "\nMemory sweep from " << from << " to " << to << " bytes.\n";
+    std::cout << std::setw(14) << "Size" << std::setw(8) << "Options" << std::setw(10) << "Seconds"
+        << std::setw(10) << "MB/s" << std::setw(12) << "RSS KiB" << '\n';
+    for (size_t size = from; size <= to; size *= 4)
+    {
+        if (generateFile(inputFileName, *findProfile("all"), size))
+            return 1;
+
+        const double bytes = std::filesystem::file_size(inputFileName);
+        sizes.push_back(bytes);
+        for (size_t i = 0; i < optionSets.size(); ++i)
+        {
+            Usage usage{};
+            const std::string command{tfcPath + " " + optionSets[i] + " -i " + inputFileName + " -o " + outputFileName};
+            if (spawn(command, usage, Limits{limit}))
+            {
+                std::cout << "  " << command << " failed with status " << usage.status << '\n';
+                err = 1;
+            }
+
+            rss[i].push_back(usage.maxRss * 1024.0);
+            std::cout << std::setw(14) << static_cast<size_t>(bytes) << std::setw(8) << optionSets[i]
+                << std::setw(10) << std::fixed << std::setprecision(3) << usage.elapsed
+                << std::setw(10) << std::setprecision(1) << (usage.elapsed ? bytes / MiB / usage.elapsed : 0)
+                << std::setw(12) << usage.maxRss << '\n';
+        }
+
+        removeFile(outputFileName);
+    }
+    removeFile(inputFileName);
+
+    for (size_t i = 0; i < optionSets.size(); ++i)
+    {
+        const double growth{slope(sizes, rss[i])};
+        std::cout << "  tfc " << optionSets[i] << " peak RSS growth: " << std::setprecision(4) << growth << " bytes per input byte\n";
+        if (growth > maxGrowth)
+        {
+            std::cout << "  tfc " << optionSets[i] << " memory grows with input size.\n";
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the memory sweep.
+ *
+ *   test memory [from [to [limit]]]
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "memory".
+ * @return int error value or 0 if no errors.
+ */
+int memoryCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t from{MiB};
+    size_t to{1024 * MiB};
+    size_t limit{256 * MiB};
+    if (((args.size() > 1) && parseSize(args[1], from)) || ((args.size() > 2) && parseSize(args[2], to)) ||
+        ((args.size() > 3) && parseSize(args[3], limit)))
+        return 1;
+    if (to < from)
+    {
+        std::cerr << "Invalid memory sweep range.\n";
+
+        return 1;
+    }
+
+    return memorySweep(dir, from, to, limit);
+}
+
+
+/**
+ * @section I/O size checks.
+ *
+ */
+
+/**
+ * @brief Run tfc on a generated file and check that it reads and writes
+ * in reasonably sized blocks rather than a line or character at a time.
+ *
+ * @param dir working directory for the generated files.
+ * @param options tfc options to use.
+ * @param size of the generated input in bytes.
+ * @return int error value or 0 if no errors.
+ */
+int ioCheck(const std::string & dir, const std::string & options, size_t size)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/io.txt"};
+    const std::string outputFileName{dir + "/ioOut.txt"};
+
+    if (generateFile(inputFileName, *findProfile("all"), size))
+        return 1;
+
+    Usage usage{};
+    const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+    int err{spawn(command, usage)};
+
+    const IoReport report{analyseIo(command, usage)};
+    std::cout << "  " << command << " : " << usage.syscr << " reads averaging " << static_cast<size_t>(report.averageRead)
+        << " bytes, " << usage.syscw << " writes averaging " << static_cast<size_t>(report.averageWrite) << " bytes\n";
+    if (report.flagged)
+        err = 1;
+
+    removeFile(inputFileName);
+    removeFile(outputFileName);
+
+    return err;
+}
+
+
+/**
+ * @section throughput benchmark.
+ *
+ */
+
+static const std::vector<std::string> benchOptions{ "-x", "-s", "-t", "-d", "-u", "-s -d", "-t -u" };
+
+// Cold runs start with more than this fraction of the input cached are
+// reported, as the file system ignored the eviction.
+static const double maxCached{0.10};
+
+// A case whose runs are too noisy is measured again up to this many times
+// before it is rejected.
+static const int maxAttempts{3};
+
+struct BenchConfig
+{
+    size_t size{64 * MiB};
+    int repeat{5};
+    std::vector<std::string> profiles{};
+    std::vector<std::string> caches{};      // "warm" and/or "cold".
+    std::string store{defaultStore};
+    std::string cpus{};                     // CPU list to pin to, empty for all.
+    int nice{};                             // Negative to raise the priority.
+    double maxNoise{};                      // Relative spread limit, 0 for none.
+};
+
+/**
+ * @brief Run a command repeatedly and return the usage of the median run
+ * and the spread of the elapsed times.
+ *
+ * @param command line to execute.
+ * @param config benchmark settings, giving the repeat count, CPUs and nice.
+ * @param usage of the run with the median elapsed time.
+ * @param noise relative spread of the elapsed times.
+ * @param evict file to drop from the page cache before each run, if any.
+ * @return int error value or 0 if no errors.
+ */
+static int measure(const std::string & command, const BenchConfig & config, Usage & usage, double & noise, const std::string & evict)
+{
+    const Limits limits{0, 0, false, parseCpuList(config.cpus), config.nice};
+    std::vector<Usage> runs(config.repeat);
+    std::vector<double> times{};
+    for (auto & run : runs)
+    {
+        if (!evict.empty() && evictFile(evict))
+            return 1;
+        if (spawn(command, run, limits))
+            return 1;
+        times.push_back(run.elapsed);
+    }
+
+    std::sort(runs.begin(), runs.end(), [](const Usage & a, const Usage & b) { return a.elapsed < b.elapsed; });
+    usage = runs[runs.size() / 2];
+    noise = relativeSpread(times);
+
+    return 0;
+}
+
+/**
+ * @brief Benchmark every option set on a generated file.
+ *
+ * @param dir working directory for the generated files.
+ * @param config benchmark settings.
+ * @param profile of the generated input.
+ * @param records for the results, appended to.
+ * @return int error value or 0 if no errors.
+ */
+static int benchProfile(const std::string & dir, const BenchConfig & config, const Profile & profile, std::vector<Record> & records)
+{
+    const std::string inputFileName{dir + "/bench.txt"};
+    const std::string outputFileName{dir + "/benchOut.txt"};
+
+    if (generateFile(inputFileName, profile, config.size))
+        return 1;
+
+    const size_t bytes{std::filesystem::file_size(inputFileName)};
+    const auto cpus{parseCpuList(config.cpus)};
+    const int cpu{cpus.empty() ? 0 : cpus.front()};
+    int err{};
+    for (const auto & cache : config.caches)
+    {
+        const bool cold{cache == "cold"};
+        if (cold)
+        {
+            const double cached{evictFile(inputFileName) ? -1 : cachedFraction(inputFileName)};
+            if ((cached < 0) || (cached > maxCached))
+                std::cout << "  Warning: unable to evict " << inputFileName << " from the page cache, "
+                    << "cold results are not cold.\n";
+        }
+
+        for (const auto & options : benchOptions)
+        {
+            Usage usage{};
+            double noise{};
+            const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+            int attempt{};
+            bool failed{};
+            do
+                failed = measure(command, config, usage, noise, cold ? inputFileName : std::string{});
+            while (!failed && config.maxNoise && (noise > config.maxNoise) && (++attempt < maxAttempts));
+
+            if (failed)
+            {
+                std::cout << "  " << command << " failed with status " << usage.status << '\n';
+                err = 1;
+                continue;
+            }
+            if (config.maxNoise && (noise > config.maxNoise))
+            {
+                std::cout << "  " << command << " rejected, " << std::fixed << std::setprecision(1) << 100 * noise
+                    << "% spread exceeds " << 100 * config.maxNoise << "% after " << maxAttempts << " attempts\n";
+                err = 1;
+                continue;
+            }
+
+            Record record{};
+            record.options = options;
+            record.profile = profile.name;
+            record.cache = cache;
+            record.cpus = config.cpus;
+            record.governor = cpuGovernor(cpu);
+            record.frequency = cpuFrequency(cpu);
+            record.noise = noise;
+            record.size = bytes;
+            record.seconds = usage.elapsed;
+            record.throughput = usage.elapsed ? bytes / static_cast<double>(MiB) / usage.elapsed : 0;
+            record.maxRss = usage.maxRss;
+            record.user = usage.user;
+            record.system = usage.system;
+            record.minorFaults = usage.minorFaults;
+            record.majorFaults = usage.majorFaults;
+            record.voluntary = usage.voluntary;
+            record.involuntary = usage.involuntary;
+            record.rchar = usage.rchar;
+            record.wchar = usage.wchar;
+            record.syscr = usage.syscr;
+            record.syscw = usage.syscw;
+            record.readBytes = usage.readBytes;
+            record.writeBytes = usage.writeBytes;
+            records.push_back(record);
+
+            std::cout << std::setw(10) << profile.name << std::setw(8) << options << std::setw(6) << cache
+                << std::setw(10) << std::fixed << std::setprecision(3) << record.seconds
+                << std::setw(10) << std::setprecision(1) << record.throughput
+                << std::setw(12) << record.maxRss
+                << std::setw(11) << record.readBytes / static_cast<double>(MiB)
+                << std::setw(8) << 100 * record.noise << '%' << std::setw(7) << std::setprecision(0) << record.frequency << '\n';
+        }
+    }
+
+    removeFile(inputFileName);
+    removeFile(outputFileName);
+
+    return err;
+}
+
+/**
+ * @brief Output the cold-cache throughput of each case as a fraction of
+ * its warm-cache throughput, if both were measured.
+ *
+ * @param records of the benchmark run.
+ */
+static void outputCacheComparison(const std::vector<Record> & records)
+{
+    bool first{true};
+    for (const auto & cold : records)
+    {
+        if (cold.cache != "cold")
+            continue;
+
+        const auto warm{std::find_if(records.begin(), records.end(), [&cold](const Record & r)
+            { return (r.cache == "warm") && (r.profile == cold.profile) && (r.options == cold.options); })};
+        if ((warm == records.end()) || !warm->throughput)
+            continue;
+
+        if (first)
+        {
+            std::cout << "\nCold-cache throughput relative to warm-cache:\n";
+            first = false;
+        }
+        std::cout << std::setw(10) << cold.profile << std::setw(8) << cold.options
+            << std::setw(10) << std::fixed << std::setprecision(2) << cold.throughput / warm->throughput << '\n';
+    }
+}
+
+/**
+ * @brief Command line entry point for the throughput benchmark. Results are
+ * appended to the history store.
+ *
+ *   test bench [--size S] [--repeat N] [--profile name]... [--cache warm|cold|both] [--store file]
+ *              [--cpus list] [--nice N] [--max-noise percent]
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "bench".
+ * @return int error value or 0 if no errors.
+ */
+int benchCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    BenchConfig config{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], config.size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], config.repeat, 1);
+        else if (args[i] == "--profile" && value)
+            config.profiles.push_back(args[++i]);
+        else if (args[i] == "--store" && value)
+            config.store = args[++i];
+        else if (args[i] == "--cache" && value && (args[i + 1] == "warm" || args[i + 1] == "cold"))
+            config.caches.push_back(args[++i]);
+        else if (args[i] == "--cache" && value && args[i + 1] == "both")
+        {
+            config.caches = { "warm", "cold" };
+            ++i;
+        }
+        else if (args[i] == "--cpus" && value)
+            config.cpus = args[++i];
+        else if (args[i] == "--nice" && value)
+            invalid |= parseInt(args[++i], config.nice, -20);
+        else if (args[i] == "--max-noise" && value)
+        {
+            invalid |= parseDouble(args[++i], config.maxNoise, 0);
+            config.maxNoise /= 100;
+        }
+        else
+        {
+            std::cerr << "Unknown bench argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (config.profiles.empty())
+        config.profiles.push_back("all");
+    if (config.caches.empty())
+        config.caches.push_back("warm");
+
+    if (!config.cpus.empty() && (parseCpuList(config.cpus).empty() || pinToCpus(parseCpuList(config.cpus))))
+    {
+        std::cerr << "Unable to pin to CPUs " << config.cpus << '\n';
+
+        return 1;
+    }
+    if (setNice(config.nice))
+    {
+        std::cerr << "Unable to set nice " << config.nice << ", running at normal priority.\n";
+        config.nice = 0;
+    }
+
+    std::filesystem::create_directories(dir);
+    std::vector<Record> records{};
+    int err{};
+
+    std::cout << "\nBenchmark of " << config.size << " byte files, median of " << config.repeat << " runs.\n";
+    std::cout << std::setw(10) << "Profile" << std::setw(8) << "Options" << std::setw(6) << "Cache" << std::setw(10) << "Seconds"
+        << std::setw(10) << "MiB/s" << std::setw(12) << "RSS KiB" << std::setw(11) << "Disk MiB"
+        << std::setw(9) << "Spread" << std::setw(7) << "MHz" << '\n';
+    for (const auto & name : config.profiles)
+    {
+        const Profile * profile{findProfile(name)};
+        if (!profile)
+        {
+            std::cerr << "Unknown profile " << name << '\n';
+            err = 1;
+            continue;
+        }
+
+        if (benchProfile(dir, config, *profile, records))
+            err = 1;
+    }
+
+    outputCacheComparison(records);
+
+    const std::string run{runStamp()};
+    const std::string build{buildId(tfcPath)};
+    const std::string host{hostInfo()};
+    for (auto & record : records)
+    {
+        record.run = run;
+        record.build = build;
+        record.host = host;
+    }
+
+    if (appendRecords(config.store, records))
+    {
+        std::cerr << "Unable to append to " << config.store << '\n';
+        err = 1;
+    }
+
+    return err;
+}
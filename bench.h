@@ -0,0 +1,74 @@
+/**
+ * @file    bench.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmark and resource usage checks for the 'tfc' utility.
+ */
+
+#if !defined(_BENCH_H__20261017_0930__INCLUDED_)
+#define _BENCH_H__20261017_0930__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+
+/**
+ * @section benchmark interface.
+ *
+ */
+
+const size_t MiB{1 << 20};
+
+extern size_t parseSize(const std::string & text);
+extern int parseSize(const std::string & text, size_t & size);
+extern int parseInt(const std::string & text, long long & value, long long min, long long max);
+extern int parseDouble(const std::string & text, double & value, double min = std::numeric_limits<double>::lowest());
+
+/**
+ * @brief Convert a command line integer into any integer type, reporting
+ * text that is not a whole number from 'min' to the largest of the type.
+ *
+ * @return int error value or 0 if the integer is valid.
+ */
+template<typename T>
+int parseInt(const std::string & text, T & value, long long min = 0)
+{
+    const unsigned long long largest{std::min<unsigned long long>(std::numeric_limits<T>::max(), std::numeric_limits<long long>::max())};
+    long long parsed{};
+    if (parseInt(text, parsed, min, static_cast<long long>(largest)))
+        return 1;
+    value = static_cast<T>(parsed);
+
+    return 0;
+}
+extern double median(std::vector<double> values);
+extern bool sameContent(const std::string & lhs, const std::string & rhs);
+extern double slope(const std::vector<double> & x, const std::vector<double> & y);
+
+extern int memoryCeiling(const std::string & dir, const std::string & options, size_t size, size_t limit);
+extern int memorySweep(const std::string & dir, size_t from, size_t to, size_t limit);
+extern int ioCheck(const std::string & dir, const std::string & options, size_t size);
+
+extern int memoryCommand(const std::string & dir, const std::vector<std::string> & args);
+extern int benchCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_BENCH_H__20261017_0930__INCLUDED_)
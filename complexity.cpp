@@ -0,0 +1,306 @@
+/**
+ * @file    complexity.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Algorithmic complexity detection across input size sweeps.
+ *
+ * Every model is fitted with a constant term, which absorbs the start up
+ * cost of tfc that dominates small inputs. Telling O(n log n) from O(n) by
+ * residuals alone is unreliable over a few points, so scaling is only
+ * flagged when the growth above the smallest input, against the growth in
+ * size, also has a log-log slope above 'maxExponent'.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "complexity.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const std::vector<std::string> complexityOptions{ "-x", "-s", "-t", "-d", "-u" };
+static const std::vector<std::string> dimensions{ "lines", "length", "indent" };
+
+// Lines in each file of the length and indent sweeps.
+static const size_t fixedLines{64};
+
+// Growth above the smallest input steeper than n^maxExponent is superlinear.
+static const double maxExponent{1.15};
+
+// Runs of each size, the median time and RSS is fitted so that one noisy
+// run cannot flag a sweep.
+static const int sweepRuns{3};
+
+struct Model
+{
+    const char * name;
+    double (*f)(double);
+};
+
+static const Model models[]{
+    { "O(n)",       [](double n) { return n; } },
+    { "O(n log n)", [](double n) { return n * std::log2(n); } },
+    { "O(n^2)",     [](double n) { return n * n; } },
+};
+
+/**
+ * @brief Sum of squared residuals of the least squares fit y = c + a f(n).
+ *
+ * @return double the residual, or infinity if the fit has a negative slope.
+ */
+static double residual(const std::vector<double> & n, const std::vector<double> & y, double (*f)(double))
+{
+    std::vector<double> x{};
+    double mx{};
+    double my{};
+    for (size_t i = 0; i < n.size(); ++i)
+    {
+        x.push_back(f(n[i]));
+        mx += x.back() / n.size();
+        my += y[i] / n.size();
+    }
+
+    const double a{slope(x, y)};
+    if (a < 0)
+        return std::numeric_limits<double>::infinity();
+
+    const double c{my - a * mx};
+    double sum{};
+    for (size_t i = 0; i < n.size(); ++i)
+        sum += (y[i] - c - a * x[i]) * (y[i] - c - a * x[i]);
+
+    return sum;
+}
+
+/**
+ * @brief Describe the line shape used for a point of a sweep.
+ *
+ * @param dimension being swept.
+ * @param size of the file in bytes.
+ * @return Profile giving files of about 'size' bytes.
+ */
+static Profile sweepProfile(const std::string & dimension, size_t size)
+{
+    // Profiles pick lengths up to their limit, so the average is half of it.
+    const size_t perLine{2 * size / fixedLines};
+
+    if (dimension == "length")
+        return Profile{"length", 0, perLine, "du"};
+    if (dimension == "indent")
+        return Profile{"indent", perLine, 8, "du"};
+
+    return Profile{"lines", 8, 72, "du"};
+}
+
+
+/**
+ * @section complexity detection implementation.
+ *
+ */
+
+/**
+ * @brief Fit measurements against the size models.
+ *
+ * @param n input sizes.
+ * @param y measurements, such as seconds or bytes of RSS.
+ * @return Scaling the best model and whether the growth is superlinear.
+ */
+Scaling fitScaling(const std::vector<double> & n, const std::vector<double> & y)
+{
+    Scaling scaling{"O(1)"};
+    if (n.size() < 3)
+        return scaling;
+
+    std::vector<double> x{};
+    std::vector<double> growth{};
+    for (size_t i = 1; i < n.size(); ++i)
+        if (y[i] > 2 * y[0])
+        {
+            x.push_back(std::log(n[i] - n[0]));
+            growth.push_back(std::log(y[i] - y[0]));
+        }
+
+    if (x.size() < 2)
+        return scaling;
+
+    double best{std::numeric_limits<double>::infinity()};
+    for (const auto & model : models)
+    {
+        const double r{residual(n, y, model.f)};
+        if (r < best)
+        {
+            best = r;
+            scaling.model = model.name;
+        }
+    }
+
+    scaling.exponent = slope(x, growth);
+    scaling.superlinear = (scaling.model != models[0].name) && (scaling.exponent > maxExponent);
+
+    return scaling;
+}
+
+/**
+ * @brief Run tfc with the given options over files growing along one
+ * dimension and report how the median run time and peak RSS of each size
+ * scale. 'from' should be large enough for the run time not to be
+ * dominated by process start up.
+ *
+ * @param dir working directory for the generated files.
+ * @param dimension to grow: "lines", "length" or "indent".
+ * @param options tfc options to use.
+ * @param from smallest input size in bytes.
+ * @param to largest input size in bytes.
+ * @param gateTime fail on superlinear run time as well as RSS if true.
+ * @return int error value or 0 if the scaling is not superlinear.
+ */
+int complexitySweep(const std::string & dir, const std::string & dimension, const std::string & options, size_t from, size_t to, bool gateTime)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/complexity.txt"};
+    const std::string outputFileName{dir + "/complexityOut.txt"};
+
+    std::vector<double> sizes{};
+    std::vector<double> seconds{};
+    std::vector<double> rss{};
+    int err{};
+    for (size_t size = from; size <= to; size *= 4)
+    {
+        if (generateFile(inputFileName, sweepProfile(dimension, size), size))
+            return 1;
+
+        const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+        std::vector<double> runSeconds{};
+        std::vector<double> runRss{};
+        for (int run = 0; run < sweepRuns && !err; ++run)
+        {
+            Usage usage{};
+            if (spawn(command, usage))
+            {
+                std::cout << "  " << command << " failed with status " << usage.status << '\n';
+                err = 1;
+            }
+            runSeconds.push_back(usage.elapsed);
+            runRss.push_back(usage.maxRss);
+        }
+        if (err)
+            break;
+
+        sizes.push_back(std::filesystem::file_size(inputFileName));
+        seconds.push_back(median(runSeconds));
+        rss.push_back(median(runRss));
+    }
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+
+    const Scaling time{fitScaling(sizes, seconds)};
+    const Scaling memory{fitScaling(sizes, rss)};
+    std::cout << std::setw(8) << dimension << std::setw(8) << options << std::fixed << std::setprecision(2)
+        << std::setw(12) << time.model << std::setw(7) << time.exponent
+        << std::setw(12) << memory.model << std::setw(7) << memory.exponent
+        << (time.superlinear ? gateTime ? "  <- time superlinear" : "  <- time superlinear (not gated)" : "")
+        << (memory.superlinear ? "  <- RSS superlinear" : "") << '\n';
+
+    if (time.superlinear || memory.superlinear)
+    {
+        for (size_t i = 0; i < sizes.size(); ++i)
+            std::cout << std::setw(30) << static_cast<size_t>(sizes[i]) << " bytes " << std::setprecision(4)
+                << std::setw(10) << seconds[i] << " s " << std::setw(10) << static_cast<long>(rss[i]) << " KiB\n";
+        if ((time.superlinear && gateTime) || memory.superlinear)
+            err = 1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the complexity sweeps.
+ *
+ *   test complexity [from [to]] [--dimension name]... [--options "opts"]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "complexity".
+ * @return int error value or 0 if no errors.
+ */
+int complexityCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t from{4 << 20};
+    size_t to{size_t{64} << 20};
+    std::vector<std::string> sweeps{};
+    std::vector<std::string> optionSets{};
+    size_t position{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--dimension" && value)
+            sweeps.push_back(args[++i]);
+        else if (args[i] == "--options" && value)
+            optionSets.push_back(args[++i]);
+        else if (position++ == 0)
+            invalid |= parseSize(args[i], from);
+        else
+            invalid |= parseSize(args[i], to);
+    }
+    if (invalid)
+        return 1;
+    if (sweeps.empty())
+        sweeps = dimensions;
+    if (optionSets.empty())
+        optionSets = complexityOptions;
+    if (to < 4 * 4 * from)
+    {
+        std::cerr << "Invalid complexity sweep range, at least 3 sizes are needed.\n";
+
+        return 1;
+    }
+
+    std::cout << "\nComplexity sweeps from " << from << " to " << to << " bytes (exponent of growth above the smallest input).\n";
+    std::cout << std::setw(8) << "Sweep" << std::setw(8) << "Options" << std::setw(12) << "Time" << std::setw(7) << "Exp"
+        << std::setw(12) << "RSS" << std::setw(7) << "Exp" << '\n';
+    int flagged{};
+    for (const auto & dimension : sweeps)
+    {
+        if (std::find(dimensions.begin(), dimensions.end(), dimension) == dimensions.end())
+        {
+            std::cerr << "Unknown dimension " << dimension << '\n';
+
+            return 1;
+        }
+
+        for (const auto & options : optionSets)
+            if (complexitySweep(dir, dimension, options, from, to))
+                ++flagged;
+    }
+
+    if (flagged)
+        std::cout << flagged << " sweep(s) scaled superlinearly or failed.\n";
+
+    return flagged ? 1 : 0;
+}
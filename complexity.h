@@ -0,0 +1,56 @@
+/**
+ * @file    complexity.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Algorithmic complexity detection across input size sweeps.
+ */
+
+#if !defined(_COMPLEXITY_H__20261017_1330__INCLUDED_)
+#define _COMPLEXITY_H__20261017_1330__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section complexity detection interface.
+ *
+ * Each sweep grows the input geometrically along one dimension while the
+ * others stay fixed:
+ *   lines  - more lines of a fixed shape,
+ *   length - a fixed number of lines that get longer,
+ *   indent - a fixed number of lines whose indentation gets deeper.
+ * Run time and peak RSS are fitted to O(n), O(n log n) and O(n^2), where n
+ * is the file size, and superlinear scaling is flagged. Run time can be
+ * reported without failing the sweep, for machines too noisy to gate on it.
+ */
+
+struct Scaling
+{
+    const char * model;     // Best fitting model, or "O(1)" if flat.
+    double exponent{};      // Log-log slope of the growth above the smallest input and size.
+    bool superlinear{};
+};
+
+extern Scaling fitScaling(const std::vector<double> & n, const std::vector<double> & y);
+extern int complexitySweep(const std::string & dir, const std::string & dimension, const std::string & options, size_t from, size_t to, bool gateTime = true);
+extern int complexityCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_COMPLEXITY_H__20261017_1330__INCLUDED_)
@@ -0,0 +1,189 @@
+/**
+ * @file    coreutils.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Differential and throughput comparison with coreutils expand/unexpand.
+ *
+ * The coreutils read standard input and write standard output, so they are
+ * run with shell redirections.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "coreutils.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const std::vector<std::string> comparableProfiles{ "dos", "unix", "mixed", "indent", "long" };
+static const int tabSizes[]{ 2, 4, 8 };
+
+struct Pair
+{
+    const char * tfc;       // tfc conversion option.
+    std::string tool;       // Equivalent coreutils command, before " -t N".
+};
+
+static const Pair pairs[]{
+    { "-s", "expand -i" },
+    { "-t", "unexpand --first-only" },
+};
+
+/**
+ * @brief Run a command repeatedly and return the median elapsed time.
+ *
+ * @return double seconds, or -1 if any run failed.
+ */
+static double medianTime(const std::string & command, int repeat)
+{
+    std::vector<double> times{};
+    for (int i = 0; i < repeat; ++i)
+    {
+        Usage usage{};
+        if (spawn(command, usage))
+            return -1;
+        times.push_back(usage.elapsed);
+    }
+
+    return median(times);
+}
+
+
+/**
+ * @section coreutils comparison implementation.
+ *
+ */
+
+/**
+ * @brief Compare tfc with expand and unexpand on a generated file of the
+ * given profile for each tab size, checking the outputs match and reporting
+ * the throughput of each.
+ *
+ * @param dir working directory for the generated files.
+ * @param profile name of the generation profile.
+ * @param size of the generated input in bytes.
+ * @param repeat number of timed runs of each command.
+ * @return int error value or 0 if every output matched.
+ */
+int coreutilsCompare(const std::string & dir, const std::string & profile, size_t size, int repeat)
+{
+    const Profile * found{findProfile(profile)};
+    if (!found)
+    {
+        std::cerr << "Unknown profile " << profile << '\n';
+
+        return 1;
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/coreutils.txt"};
+    const std::string tfcFileName{dir + "/coreutilsTfc.txt"};
+    const std::string toolFileName{dir + "/coreutilsTool.txt"};
+    if (generateFile(inputFileName, *found, size))
+        return 1;
+
+    const double bytes = std::filesystem::file_size(inputFileName);
+    int err{};
+    for (const auto & pair : pairs)
+        for (const auto tabSize : tabSizes)
+        {
+            const std::string tab{std::to_string(tabSize)};
+            const std::string tfc{tfcPath + " " + pair.tfc + " -" + tab + " -i " + inputFileName + " -o " + tfcFileName};
+            const std::string tool{pair.tool + " -t " + tab + " < " + inputFileName + " > " + toolFileName};
+
+            const double tfcTime{medianTime(tfc, repeat)};
+            const double toolTime{medianTime(tool, repeat)};
+            const bool same{(tfcTime >= 0) && (toolTime >= 0) && sameContent(tfcFileName, toolFileName)};
+
+            std::cout << std::setw(8) << profile << std::setw(6) << (std::string{pair.tfc} + " -" + tab)
+                << std::setw(26) << (pair.tool + " -t " + tab) << std::fixed << std::setprecision(1)
+                << std::setw(10) << (tfcTime > 0 ? bytes / static_cast<double>(MiB) / tfcTime : 0)
+                << std::setw(10) << (toolTime > 0 ? bytes / static_cast<double>(MiB) / toolTime : 0)
+                << std::setw(8) << std::setprecision(2) << (tfcTime > 0 ? toolTime / tfcTime : 0)
+                << "  " << (same ? "identical" : "DIFFERENT") << '\n';
+
+            if (!same)
+                err = 1;
+        }
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(tfcFileName);
+    std::filesystem::remove(toolFileName);
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the coreutils comparison.
+ *
+ *   test coreutils [--size S] [--repeat N] [--profile name]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "coreutils".
+ * @return int error value or 0 if no errors.
+ */
+int coreutilsCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t size{64 << 20};
+    int repeat{3};
+    std::vector<std::string> profiles{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], repeat, 1);
+        else if (args[i] == "--profile" && value)
+            profiles.push_back(args[++i]);
+        else
+        {
+            std::cerr << "Unknown coreutils argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (profiles.empty())
+        profiles = comparableProfiles;
+
+    std::cout << "\nComparison with coreutils on " << size << " byte files, median of " << repeat << " runs.\n";
+    std::cout << std::setw(8) << "Profile" << std::setw(6) << "tfc" << std::setw(26) << "coreutils"
+        << std::setw(10) << "tfc MiB/s" << std::setw(10) << "cu MiB/s" << std::setw(8) << "Speed" << "  Output\n";
+
+    int differences{};
+    for (const auto & profile : profiles)
+        if (coreutilsCompare(dir, profile, size, repeat))
+            ++differences;
+
+    if (differences)
+        std::cout << differences << " profile(s) gave output different from coreutils.\n";
+
+    return differences ? 1 : 0;
+}
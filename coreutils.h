@@ -0,0 +1,45 @@
+/**
+ * @file    coreutils.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Differential and throughput comparison with coreutils expand/unexpand.
+ */
+
+#if !defined(_COREUTILS_H__20261017_1530__INCLUDED_)
+#define _COREUTILS_H__20261017_1530__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section coreutils comparison interface.
+ *
+ * 'tfc -s -N' is compared with 'expand -i -t N' and 'tfc -t -N' with
+ * 'unexpand --first-only -t N'. Their semantics match for files whose lines
+ * end in LF or CRLF; a malformed LFCR EOL puts a CR at the start of the
+ * next line, which the coreutils see as the end of the leading whitespace,
+ * so the malformed and "all" profiles are not compared.
+ */
+
+extern int coreutilsCompare(const std::string & dir, const std::string & profile, size_t size, int repeat);
+extern int coreutilsCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_COREUTILS_H__20261017_1530__INCLUDED_)
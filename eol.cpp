@@ -0,0 +1,147 @@
+/**
+ * @file    eol.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * EOL normalisation kernels for producing expected DOS and Unix output.
+ */
+
+#include <cstring>
+
+#include "summary.h"
+#include "eol.h"
+
+
+/**
+ * @section EOL normalisation implementation.
+ *
+ */
+
+size_t EolNormaliser::writeEol(char * out) const
+{
+    if (mode == TO_UNIX)
+    {
+        out[0] = '\n';
+
+        return 1;
+    }
+
+    out[0] = '\r';
+    out[1] = '\n';
+
+    return 2;
+}
+
+/**
+ * @brief Normalise the EOLs in the next block of the stream. An EOL
+ * character at the end of the block is held until the next byte is known.
+ *
+ * @param data of the block.
+ * @param length of the block in bytes.
+ * @param out buffer of at least space(length) bytes for the result.
+ * @return size_t the number of bytes written to 'out'.
+ */
+size_t EolNormaliser::add(const char * data, size_t length, char * out)
+{
+    if (mode == KEEP_EOL)
+    {
+        std::memcpy(out, data, length);
+
+        return length;
+    }
+
+    size_t written{};
+    size_t i{};
+    if (pending && length)
+    {
+        const char c{data[0]};
+        if ((c == '\n' || c == '\r') && c != pending)
+            ++i;
+        written += writeEol(out);
+        pending = 0;
+    }
+
+    while (i < length)
+    {
+        const size_t eol{findEol(data, i, length)};
+        std::memcpy(out + written, data + i, eol - i);
+        written += eol - i;
+        if (eol == length)
+            break;
+
+        const char c{data[eol]};
+        i = eol + 1;
+        if (i == length)
+        {
+            pending = c;
+            break;
+        }
+
+        if ((data[i] == '\n' || data[i] == '\r') && data[i] != c)
+            ++i;
+        written += writeEol(out + written);
+    }
+
+    return written;
+}
+
+/**
+ * @brief Write any EOL held at the end of the stream.
+ *
+ * @param out buffer of at least space(0) bytes.
+ * @return size_t the number of bytes written to 'out'.
+ */
+size_t EolNormaliser::finish(char * out)
+{
+    const size_t written{pending ? writeEol(out) : 0};
+    pending = 0;
+
+    return written;
+}
+
+/**
+ * @brief Normalise the EOLs of a whole buffer.
+ *
+ * @param data to normalise.
+ * @param mode TO_DOS or TO_UNIX, KEEP_EOL returns a copy.
+ * @return std::vector<char> the normalised data.
+ */
+std::vector<char> normaliseEols(const std::vector<char> & data, EolMode mode)
+{
+    if (mode == KEEP_EOL)
+        return data;
+
+    std::vector<char> out(EolNormaliser::space(data.size()));
+    EolNormaliser normaliser{mode};
+    size_t written{normaliser.add(data.data(), data.size(), out.data())};
+    written += normaliser.finish(out.data() + written);
+    out.resize(written);
+
+    return out;
+}
+
+/**
+ * @brief Normalise the EOLs of the buffer of a BinaryFile.
+ *
+ * @param file whose buffer is normalised.
+ * @param mode TO_DOS or TO_UNIX.
+ */
+void normaliseEols(BinaryFile<> & file, EolMode mode)
+{
+    file.moveData(normaliseEols(file.moveData(), mode));
+}
@@ -0,0 +1,68 @@
+/**
+ * @file    eol.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * EOL normalisation kernels for producing expected DOS and Unix output.
+ */
+
+#if !defined(_EOL_H__20261017_1830__INCLUDED_)
+#define _EOL_H__20261017_1830__INCLUDED_
+
+#include <string>
+#include <vector>
+
+#include "BinaryFile.h"
+
+
+/**
+ * @section EOL normalisation interface.
+ *
+ * Every line ending, "\r\n", "\n", or the malformed "\n\r" or CR on its
+ * own, is replaced by "\r\n" for 'tfc -d' or "\n" for 'tfc -u', the same
+ * line endings that SummaryCounter counts. The kernel jumps from one CR or
+ * LF to the next with the SSE2 search used by the summary kernel and copies
+ * the bytes in between.
+ */
+
+enum EolMode { KEEP_EOL, TO_DOS, TO_UNIX };
+
+class EolNormaliser
+{
+public:
+    EolNormaliser(EolMode mode) : mode{mode} {}
+
+    size_t add(const char * data, size_t length, char * out);
+    size_t finish(char * out);
+
+    // Bytes of output space needed for 'length' bytes of input.
+    static size_t space(size_t length) { return 2 * length + 2; }
+
+private:
+    size_t writeEol(char * out) const;
+
+    const EolMode mode;
+    char pending{};     // EOL character ending the last block, waiting on the next byte.
+
+};
+
+extern std::vector<char> normaliseEols(const std::vector<char> & data, EolMode mode);
+extern void normaliseEols(BinaryFile<> & file, EolMode mode);
+
+
+#endif // !defined(_EOL_H__20261017_1830__INCLUDED_)
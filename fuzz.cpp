@@ -0,0 +1,451 @@
+/**
+ * @file    fuzz.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Runtime guided performance fuzzing of tfc.
+ *
+ * There is no coverage feedback: a mutant joins the population if it costs
+ * more per byte than the input it was mutated from, and is saved to the
+ * slow input corpus if, on a second measurement, it still costs at least
+ * 'threshold' times the baseline of the "all" profile.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <limits>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "fuzz.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const std::vector<std::string> fuzzOptions{ "-x", "-s -d", "-t -u" };
+
+// Largest pattern a mutation may produce.
+static const size_t maxPattern{64 << 10};
+
+// Most patterns kept in the population, the cheapest is dropped beyond it.
+static const size_t maxPopulation{32};
+
+// A mutant must beat its parent by this fraction to join the population.
+static const double instructionMargin{0.05};
+static const double wallMargin{0.20};
+
+static const size_t memoryLimit{256 << 20};
+
+static const char interesting[]{ ' ', '\t', '\r', '\n', '\0', 'a', ';' };
+
+struct Candidate
+{
+    std::string pattern;
+    std::string options;
+    Cost cost;
+};
+
+static std::string readFile(const std::string & fileName, size_t limit)
+{
+    std::ifstream is{fileName, std::ios::binary};
+    std::string content(limit, '\0');
+    is.read(content.data(), content.size());
+    content.resize(is.gcount());
+
+    return content;
+}
+
+static std::string hashName(const std::string & pattern, const std::string & options)
+{
+    uint64_t hash{0xcbf29ce484222325ULL};
+    for (const auto c : options + '\0' + pattern)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+
+    std::ostringstream os{};
+    os << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    return os.str();
+}
+
+/**
+ * @brief Apply one random mutation to a pattern.
+ *
+ * @param pattern to mutate.
+ * @param other pattern to splice from.
+ * @param random number generator.
+ * @param name of the mutation applied, set on return.
+ * @return std::string the mutant.
+ */
+static std::string mutate(const std::string & pattern, const std::string & other, std::mt19937_64 & random, const char * & name)
+{
+    auto pick = [&random](size_t limit) { return limit ? std::uniform_int_distribution<size_t>{0, limit - 1}(random) : 0; };
+
+    std::string mutant{pattern.empty() ? std::string{"\n"} : pattern};
+    const size_t pos{pick(mutant.size())};
+    const size_t length{1 + pick(std::min<size_t>(mutant.size() - pos, 256))};
+    const char c{interesting[pick(sizeof(interesting))]};
+
+    switch (pick(6))
+    {
+    case 0:
+        name = "replace byte";
+        mutant[pos] = c;
+        break;
+
+    case 1:
+        name = "insert run";
+        mutant.insert(pos, 1 + pick(4096), c);
+        break;
+
+    case 2:
+        name = "delete range";
+        mutant.erase(pos, length);
+        break;
+
+    case 3:
+        name = "duplicate range";
+        mutant.insert(pos, mutant.substr(pos, length));
+        break;
+
+    case 4:
+        name = "join lines";
+        mutant.erase(std::remove(mutant.begin(), mutant.end(), '\n'), mutant.end());
+        break;
+
+    default:
+        name = "splice";
+        mutant = mutant.substr(0, pos) + other.substr(pick(other.size()));
+        break;
+    }
+
+    if (mutant.size() > maxPattern)
+        mutant.resize(maxPattern);
+
+    return mutant;
+}
+
+/**
+ * @brief Save a slow pattern to the corpus and index it.
+ *
+ * @return std::string the name of the saved file.
+ */
+static std::string saveSlowInput(const std::string & corpus, const Candidate & slow, double ratio, size_t size)
+{
+    std::filesystem::create_directories(corpus);
+    const std::string fileName{corpus + "/" + hashName(slow.pattern, slow.options) + ".txt"};
+    if (std::ofstream os{fileName, std::ios::binary|std::ios::out})
+        os.write(slow.pattern.data(), slow.pattern.size());
+
+    const std::string indexName{corpus + "/index.csv"};
+    const bool create{!std::filesystem::exists(indexName)};
+    if (std::ofstream os{indexName, std::ios::out|std::ios::app})
+    {
+        if (create)
+            os << "file,options,pattern,size,ratio,instructions,cpuNs,wallNs\n";
+        os << std::filesystem::path{fileName}.filename().string() << ',' << slow.options << ',' << slow.pattern.size()
+            << ',' << size << ',' << ratio << ',' << slow.cost.instructions << ',' << slow.cost.cpu << ',' << slow.cost.wall << '\n';
+    }
+
+    return fileName;
+}
+
+
+/**
+ * @section performance fuzzer implementation.
+ *
+ */
+
+/**
+ * @brief Write a pattern repeatedly until the file is at least 'size' bytes.
+ *
+ * @param fileName of the file to write.
+ * @param pattern to repeat.
+ * @param size minimum number of bytes.
+ * @return int error value or 0 if no errors.
+ */
+int tileFile(const std::string & fileName, const std::string & pattern, size_t size)
+{
+    if (pattern.empty())
+        return 1;
+
+    if (std::ofstream os{fileName, std::ios::binary|std::ios::out})
+    {
+        std::string block{};
+        while (block.size() < (1 << 20))
+            block += pattern;
+
+        for (size_t written = 0; written < size; written += block.size())
+            if (!os.write(block.data(), block.size()))
+                return 1;
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Measure the per byte cost of tfc on a pattern tiled to 'size'
+ * bytes, taking the median of three runs.
+ *
+ * @param dir working directory for the generated files.
+ * @param pattern to tile.
+ * @param options tfc options to use.
+ * @param size minimum number of bytes to tile the pattern to.
+ * @param timeout in seconds for each run, 0 for no limit.
+ * @return Cost the cost of the pattern.
+ */
+Cost measureCost(const std::string & dir, const std::string & pattern, const std::string & options, size_t size, double timeout)
+{
+    const std::string inputFileName{dir + "/fuzz.txt"};
+    const std::string outputFileName{dir + "/fuzzOut.txt"};
+
+    Cost cost{};
+    if (tileFile(inputFileName, pattern, size))
+    {
+        cost.status = -1;
+
+        return cost;
+    }
+
+    const double bytes = std::filesystem::file_size(inputFileName);
+    const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+    Limits limits{memoryLimit, timeout};
+    limits.countInstructions = true;
+
+    std::vector<double> instructions{};
+    std::vector<double> cpu{};
+    std::vector<double> wall{};
+    for (int run = 0; run < 3; ++run)
+    {
+        Usage usage{};
+        cost.status = spawn(command, usage, limits);
+        cost.timedOut = usage.timedOut;
+        if (cost.status || cost.timedOut)
+            break;
+
+        if (usage.instructions > 0)
+            instructions.push_back(usage.instructions / bytes);
+        cpu.push_back((usage.user + usage.system) * 1e9 / bytes);
+        wall.push_back(usage.elapsed * 1e9 / bytes);
+    }
+
+    cost.instructions = median(instructions);
+    cost.cpu = median(cpu);
+    cost.wall = median(wall);
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+
+    return cost;
+}
+
+/**
+ * @brief Get a cost relative to a baseline, by instructions where both
+ * were counted and by CPU time otherwise.
+ *
+ * @param cost to compare.
+ * @param baseline to compare with.
+ * @return double the ratio, infinite if the run timed out.
+ */
+double costRatio(const Cost & cost, const Cost & baseline)
+{
+    if (cost.timedOut)
+        return std::numeric_limits<double>::infinity();
+    if (cost.instructions && baseline.instructions)
+        return cost.instructions / baseline.instructions;
+
+    return baseline.cpu ? cost.cpu / baseline.cpu : 0;
+}
+
+/**
+ * @brief Load the seed patterns: the test1 to test4 fixtures and a sample
+ * of each generation profile.
+ *
+ * @param dir working directory for the generated files.
+ * @param inputDir directory holding the test fixtures.
+ * @param baseline set to the "all" profile sample, empty if it could not be
+ * generated.
+ * @return std::vector<std::string> the seed patterns.
+ */
+std::vector<std::string> loadSeeds(const std::string & dir, const std::string & inputDir, std::string & baseline)
+{
+    baseline.clear();
+    std::vector<std::string> seeds{};
+    for (int i = 1; i <= 4; ++i)
+    {
+        const std::string seed{readFile(inputDir + "/test" + std::to_string(i) + ".txt", maxPattern)};
+        if (!seed.empty())
+            seeds.push_back(seed);
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string sampleFileName{dir + "/seed.txt"};
+    for (const std::string name : { "dos", "unix", "malformed", "mixed", "all", "indent", "long" })
+        if (!generateFile(sampleFileName, *findProfile(name), 16 << 10))
+        {
+            seeds.push_back(readFile(sampleFileName, maxPattern));
+            if (name == "all")
+                baseline = seeds.back();
+        }
+    std::filesystem::remove(sampleFileName);
+
+    return seeds;
+}
+
+/**
+ * @brief Search for patterns on which tfc is slow per byte, saving those
+ * that cost at least 'threshold' times the baseline to the corpus.
+ *
+ * @param dir working directory for the generated files.
+ * @param seeds initial patterns.
+ * @param reference pattern whose cost is the baseline of each option set.
+ * @param config of the fuzzer.
+ * @return int the number of slow inputs saved, or -1 on error.
+ */
+int fuzz(const std::string & dir, const std::vector<std::string> & seeds, const std::string & reference, const FuzzConfig & config)
+{
+    if (seeds.empty() || reference.empty())
+    {
+        std::cerr << "The fuzzer needs seeds and a baseline pattern.\n";
+
+        return -1;
+    }
+
+    std::filesystem::create_directories(dir);
+    std::mt19937_64 random{config.seed};
+    const auto optionSets{config.optionSets.empty() ? fuzzOptions : config.optionSets};
+
+    std::vector<Cost> baselines{};
+    std::vector<Candidate> population{};
+    for (const auto & options : optionSets)
+    {
+        baselines.push_back(measureCost(dir, reference, options, config.size));
+        if (baselines.back().status)
+        {
+            std::cerr << "tfc " << options << " failed on the baseline.\n";
+
+            return -1;
+        }
+        for (const auto & seed : seeds)
+            population.push_back(Candidate{seed, options, measureCost(dir, seed, options, config.size)});
+    }
+
+    const bool counted{baselines.front().instructions > 0};
+    std::cout << "\nFuzzing " << population.size() << " seeds for " << config.iterations << " iterations, measured in "
+        << (counted ? "instructions" : "CPU time") << " per byte of " << config.size << " byte files.\n";
+
+    int saved{};
+    for (int i = 1; i <= config.iterations; ++i)
+    {
+        const Candidate & parent{population[std::uniform_int_distribution<size_t>{0, population.size() - 1}(random)]};
+        const Candidate & other{population[std::uniform_int_distribution<size_t>{0, population.size() - 1}(random)]};
+        const size_t o{static_cast<size_t>(std::find(optionSets.begin(), optionSets.end(), parent.options) - optionSets.begin())};
+        const Cost & baseline{baselines[o]};
+
+        const char * mutation{};
+        Candidate child{mutate(parent.pattern, other.pattern, random, mutation), parent.options, Cost{}};
+        child.cost = measureCost(dir, child.pattern, child.options, config.size, 10 * baseline.wall * config.size / 1e9 + 2);
+        if (child.cost.status && !child.cost.timedOut)
+            continue;   // tfc rejected the input.
+
+        const bool costlier{costRatio(child.cost, parent.cost) > 1 + instructionMargin};
+        const bool slower{parent.cost.wall && (child.cost.wall > parent.cost.wall * (1 + wallMargin))};
+        if (!costlier && !slower)
+            continue;
+
+        const double ratio{costRatio(child.cost, baseline)};
+        std::cout << std::setw(6) << i << std::setw(8) << child.options << std::setw(16) << mutation << std::fixed << std::setprecision(2)
+            << std::setw(9) << ratio << "x baseline" << (child.cost.timedOut ? ", timed out" : "");
+
+        if (ratio >= config.threshold)
+        {
+            const Cost confirm{child.cost.timedOut ? child.cost : measureCost(dir, child.pattern, child.options, config.size)};
+            if (costRatio(confirm, baseline) >= config.threshold)
+            {
+                std::cout << ", saved " << saveSlowInput(config.corpus, child, ratio, config.size);
+                ++saved;
+            }
+        }
+        std::cout << '\n';
+
+        population.push_back(child);
+        if (population.size() > maxPopulation)
+            population.erase(std::min_element(population.begin(), population.end(),
+                [&](const Candidate & a, const Candidate & b) { return costRatio(a.cost, b.cost) < 1; }));
+    }
+
+    std::cout << saved << " slow input(s) saved to " << config.corpus << ".\n";
+
+    return saved;
+}
+
+/**
+ * @brief Command line entry point for the performance fuzzer.
+ *
+ *   test fuzz [--iterations N] [--size S] [--seed N] [--threshold X] [--options "opts"]... [--corpus dir]
+ *
+ * @param dir working directory for the generated files.
+ * @param inputDir directory holding the test fixtures.
+ * @param args command line arguments, starting with "fuzz".
+ * @return int error value or 0 if no errors.
+ */
+int fuzzCommand(const std::string & dir, const std::string & inputDir, const std::vector<std::string> & args)
+{
+    FuzzConfig config{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--iterations" && value)
+            invalid |= parseInt(args[++i], config.iterations, 1);
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], config.size);
+        else if (args[i] == "--seed" && value)
+            invalid |= parseInt(args[++i], config.seed);
+        else if (args[i] == "--threshold" && value)
+            invalid |= parseDouble(args[++i], config.threshold, 0);
+        else if (args[i] == "--options" && value)
+            config.optionSets.push_back(args[++i]);
+        else if (args[i] == "--corpus" && value)
+            config.corpus = args[++i];
+        else
+        {
+            std::cerr << "Unknown fuzz argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    std::string baseline{};
+    const auto seeds{loadSeeds(dir, inputDir, baseline)};
+
+    return fuzz(dir, seeds, baseline, config) < 0 ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file    fuzz.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Runtime guided performance fuzzing of tfc.
+ */
+
+#if !defined(_FUZZ_H__20261017_1430__INCLUDED_)
+#define _FUZZ_H__20261017_1430__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * @section performance fuzzer interface.
+ *
+ * An input is a pattern that is tiled to 'size' bytes before tfc is run on
+ * it, so that the cost measured is the steady state cost of the pattern
+ * rather than the start up cost of tfc. Cost is measured per byte of the
+ * tiled file, in instructions where hardware counters are available and
+ * in CPU time otherwise, and in wall clock time.
+ */
+
+struct Cost
+{
+    double instructions{};  // Per byte, 0 if not counted.
+    double cpu{};           // Nanoseconds of CPU time per byte.
+    double wall{};          // Nanoseconds per byte.
+    int status{};
+    bool timedOut{};
+};
+
+struct FuzzConfig
+{
+    int iterations{200};
+    size_t size{4 << 20};                   // Bytes each pattern is tiled to.
+    uint64_t seed{1};
+    double threshold{2};                    // Cost relative to the baseline to save.
+    std::vector<std::string> optionSets{};
+    std::string corpus{"slow-inputs"};
+};
+
+extern int tileFile(const std::string & fileName, const std::string & pattern, size_t size);
+extern Cost measureCost(const std::string & dir, const std::string & pattern, const std::string & options, size_t size, double timeout = 0);
+extern double costRatio(const Cost & cost, const Cost & baseline);
+
+extern std::vector<std::string> loadSeeds(const std::string & dir, const std::string & inputDir, std::string & baseline);
+extern int fuzz(const std::string & dir, const std::vector<std::string> & seeds, const std::string & reference, const FuzzConfig & config);
+extern int fuzzCommand(const std::string & dir, const std::string & inputDir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_FUZZ_H__20261017_1430__INCLUDED_)
@@ -24,9 +24,18 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "TextFile.h"
 #include "BinaryFile.h"
+#include "gen.h"
+#include "bench.h"
+#include "results.h"
+#include "trace.h"
 
 /**
  * @section basic utility code.
@@ -36,14 +45,36 @@ std::string inputDir{};
 std::string outputDir{};
 std::string expectedDir{};
 
+size_t checkpointInterval{64 << 20};
+
 static bool createDirectory(const std::string & path)
 {
     return std::filesystem::create_directories(path);
 }
 
-static void deleteDirectory(const std::string & path)
+/**
+ * @brief Delete the contents of a directory, except for partly generated
+ * files and their journals, so that their generation can be resumed.
+ */
+static void clearDirectory(const std::string & path)
 {
-    std::filesystem::remove_all(path); // Delete directory and contents.
+    std::error_code ec{};
+    std::vector<std::filesystem::path> files{};
+    for (std::filesystem::recursive_directory_iterator it{path, ec}, end{}; !ec && it != end; it.increment(ec))
+        if (!it->is_directory(ec))
+            files.push_back(it->path());
+
+    auto journalled = [](const std::filesystem::path & file)
+    {
+        const std::string name{file.string()};
+        const std::string suffix{".journal"};
+
+        return (name.ends_with(suffix) && std::filesystem::exists(name.substr(0, name.length() - suffix.length()))) ||
+            std::filesystem::exists(name + suffix);
+    };
+    for (const auto & file : files)
+        if (!journalled(file))
+            std::filesystem::remove(file, ec);
 }
 
 static int writeSummaryFile(const std::string & fileName, const std::string & line2)
@@ -927,6 +958,441 @@ int optionsTests(void)
 }
 
 
+/**
+ * @section large file generation.
+ *
+ * Files are streamed to disk a block at a time from a seeded generator so
+ * that inputs far larger than available memory can be created, and the same
+ * seed always reproduces the same file.
+ */
+
+static const Profile profiles[]{
+    { "dos",       8, 40, "d" },
+    { "unix",      8, 40, "u" },
+    { "malformed", 8, 40, "m" },
+    { "mixed",     8, 40, "du" },
+    { "all",       8, 40, "dum" },
+    { "indent",   64, 40, "du" },
+    { "long",      8, 4000, "du" },
+};
+
+/**
+ * @brief Look up a generation profile by name.
+ * 
+ * @param name of the required profile.
+ * @return const Profile* the matching profile or nullptr if not found.
+ */
+const Profile * findProfile(const std::string & name)
+{
+    for (const auto & profile : profiles)
+        if (name == profile.name)
+            return &profile;
+
+    return nullptr;
+}
+
+class LineGenerator
+{
+public:
+    LineGenerator(const Profile & profile, uint64_t seed) : profile{profile}, state{seed ? seed : 1}, lines{} {}
+
+    void append(std::string & buffer);
+
+    void save(std::ostream & os) const;
+    bool load(std::istream & is);
+
+private:
+    uint64_t next(void);
+    size_t pick(size_t limit) { return limit ? next() % (limit + 1) : 0; }
+
+    const Profile & profile;
+    uint64_t state;
+    size_t lines;
+
+};
+
+/**
+ * @brief xorshift64* step, small enough to checkpoint as a single value.
+ * 
+ * @return uint64_t the next pseudo random value.
+ */
+uint64_t LineGenerator::next(void)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Append one randomly generated line, including EOL, to the buffer.
+ * 
+ * @param buffer to append the line to.
+ */
+void LineGenerator::append(std::string & buffer)
+{
+    static const std::string body{"abcdefghijklmnopqrstuvwxyz0123456789.;{}() \t"};
+
+    for (size_t i = pick(profile.indent); i; --i)
+        buffer.push_back((next() & 1) ? '\t' : ' ');
+
+    for (size_t i = pick(profile.length); i; --i)
+        buffer.push_back(body[next() % body.length()]);
+
+    switch (profile.eols[next() % std::strlen(profile.eols)])
+    {
+    case 'd': buffer.append("\r\n"); break;
+    case 'm': buffer.append("\n\r"); break;
+    case 'c': buffer.push_back('\r'); break;
+    case 'a': buffer.append(lines % 3 == 0 ? "\r\n" : lines % 3 == 1 ? "\n" : "\n\r"); break;
+    case 'n': break;
+    default:  buffer.push_back('\n'); break;
+    }
+    ++lines;
+}
+
+/**
+ * @brief Write the generator state so generation can resume from it.
+ * 
+ * @param os stream to write to.
+ */
+void LineGenerator::save(std::ostream & os) const
+{
+    os << state << ' ' << lines << '\n';
+}
+
+/**
+ * @brief Read the generator state written by save().
+ * 
+ * @param is stream to read from.
+ * @return true if the state was read.
+ */
+bool LineGenerator::load(std::istream & is)
+{
+    uint64_t loadedState{};
+    size_t loadedLines{};
+    if (!(is >> loadedState >> loadedLines) || !loadedState)
+        return false;
+
+    state = loadedState;
+    lines = loadedLines;
+
+    return true;
+}
+
+/**
+ * @brief Flush a file or directory to disk.
+ *
+ * @return int error value or 0 if no errors.
+ */
+static int syncFile(const std::string & fileName)
+{
+    const int fd{open(fileName.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return 1;
+
+    const bool failed{fsync(fd) < 0};
+    close(fd);
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * @brief Write a generation journal atomically, so that an interruption,
+ * including a crash or power loss, leaves either the previous journal or
+ * this one. The data file must already be synced up to 'written' bytes.
+ * 
+ * @return int error value or 0 if no errors.
+ */
+static int saveJournal(const std::string & journalFileName, const std::string & key, size_t written, const LineGenerator & generator)
+{
+    const std::string tempFileName{journalFileName + ".tmp"};
+    {
+        std::ofstream os{tempFileName};
+        if (!os)
+            return 1;
+
+        os << key << '\n' << written << '\n';
+        generator.save(os);
+        if (!os.flush())
+            return 1;
+    }
+    if (syncFile(tempFileName))
+        return 1;
+
+    std::error_code ec{};
+    std::filesystem::rename(tempFileName, journalFileName, ec);
+    if (ec)
+        return 1;
+
+    const std::string parent{std::filesystem::path{journalFileName}.parent_path().string()};
+
+    return syncFile(parent.empty() ? "." : parent);
+}
+
+/**
+ * @brief Make the key identifying a generated file's journal. Every
+ * parameter of the profile is included, as profiles built elsewhere, such
+ * as the complexity sweeps, may share a name with different parameters.
+ *
+ * @return std::string the key.
+ */
+static std::string journalKey(const Profile & profile, size_t size, uint64_t seed, Fixup fixup)
+{
+    return std::string{profile.name} + ' ' + std::to_string(profile.indent) + ' ' + std::to_string(profile.length) + ' ' +
+        profile.eols + ' ' + std::to_string(size) + ' ' + std::to_string(seed) + ' ' + std::to_string(fixup);
+}
+
+/**
+ * @brief Restore the generator from a journal written for the same file,
+ * profile, size, seed and fixup, and cut the file back to the journalled
+ * length.
+ * 
+ * @return size_t the number of bytes to resume from, 0 to start again.
+ */
+static size_t loadJournal(const std::string & fileName, const std::string & journalFileName, const std::string & key, LineGenerator & generator)
+{
+    std::ifstream is{journalFileName};
+    std::string journalKey{};
+    size_t written{};
+    if (!is || !std::getline(is, journalKey) || (journalKey != key) || !(is >> written))
+        return 0;
+
+    std::error_code ec{};
+    if (std::filesystem::file_size(fileName, ec) < written || ec)
+        return 0;
+
+    std::filesystem::resize_file(fileName, written, ec);
+
+    return (ec || !generator.load(is)) ? 0 : written;
+}
+
+/**
+ * @brief Stream generated lines to disk a block at a time, applying the
+ * fixup to each block.
+ *
+ * Every 'checkpointInterval' bytes the file is synced to disk and the
+ * generator state and bytes written are saved in 'fileName'.journal. If a matching
+ * journal is found, generation resumes from it and produces the same bytes
+ * as an uninterrupted run. The journal is removed once the file is
+ * complete.
+ * 
+ * @param fileName of the file to generate.
+ * @param profile describing the lines to generate.
+ * @param size minimum number of bytes to generate.
+ * @param seed for the line generator.
+ * @param fixup applied to the generated blocks.
+ * @param stop number of bytes after which to stop as if interrupted.
+ * @return int error value or 0 if no errors.
+ */
+static int streamFile(const std::string & fileName, const Profile & profile, size_t size, uint64_t seed, Fixup fixup, size_t stop = SIZE_MAX)
+{
+    const size_t blockSize{1 << 20};
+    const std::string journalFileName{fileName + ".journal"};
+    const std::string key{journalKey(profile, size, seed, fixup)};
+
+    LineGenerator generator{profile, seed};
+    size_t written{loadJournal(fileName, journalFileName, key, generator)};
+    if (written)
+        std::cout << "Resuming " << profile.name << " file " << fileName << " (" << size << " bytes) from " << written << " bytes\n";
+    else
+        std::cout << "Generating " << profile.name << " file " << fileName << " (" << size << " bytes)\n";
+    const auto mode{written ? std::ios::binary|std::ios::in|std::ios::out|std::ios::ate : std::ios::binary|std::ios::out};
+    if (std::ofstream os{fileName, mode})
+    {
+        const double traceStart{traceClock()};
+        Stopwatch stopwatch{};
+        const size_t resumed{written};
+        size_t checkpoint{written};
+        std::string block;
+        block.reserve(blockSize + profile.indent + profile.length + 3);
+
+        for (; written < size; written += block.size())
+        {
+            if (written - checkpoint >= checkpointInterval)
+            {
+                if (!os.flush() || syncFile(fileName) || saveJournal(journalFileName, key, written, generator))
+                    return 1;
+                checkpoint = written;
+            }
+            if (written >= stop)
+                return 0;
+
+            block.clear();
+            while ((block.size() < blockSize) && (written + block.size() < size))
+                generator.append(block);
+
+            const bool last{written + block.size() >= size};
+            if (fixup == NUL)
+                std::replace(block.begin(), block.end(), ';', '\0');
+            else if ((fixup == STRIP_EOL) && last)
+                while (!block.empty() && (block.back() == '\n' || block.back() == '\r'))
+                    block.pop_back();
+            else if ((fixup == ADD_EOL) && last)
+                block.push_back('\n');
+
+            if (!os.write(block.data(), block.size()))
+                return 1;
+        }
+        if (!os.flush())
+            return 1;
+        std::filesystem::remove(journalFileName);
+        recordPhase(GENERATE, stopwatch.elapsed(), written - resumed);
+        traceEvent("generate", "generate", traceStart, { { "file", fileName }, { "bytes", std::to_string(written - resumed) } });
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Stream a generated file of at least 'size' bytes to disk.
+ * 
+ * @param fileName of the file to generate.
+ * @param profile describing the lines to generate.
+ * @param size minimum number of bytes to generate, the last line is always complete.
+ * @param seed for the line generator.
+ * @return int error value or 0 if no errors.
+ */
+int generateFile(const std::string & fileName, const Profile & profile, size_t size, uint64_t seed)
+{
+    return streamFile(fileName, profile, size, seed, NONE);
+}
+
+/**
+ * @brief Stream a generated file but stop after at least 'stop' bytes, as
+ * if interrupted, leaving the journal of the last checkpoint in place.
+ * 
+ * @param fileName of the file to generate.
+ * @param profile describing the lines to generate.
+ * @param size minimum number of bytes to generate.
+ * @param stop number of bytes after which to stop.
+ * @param seed for the line generator.
+ * @return int error value or 0 if no errors.
+ */
+int interruptGeneration(const std::string & fileName, const Profile & profile, size_t size, size_t stop, uint64_t seed)
+{
+    return streamFile(fileName, profile, size, seed, NONE, stop);
+}
+
+
+/**
+ * @section pathological file generation.
+ *
+ * Adversarial shapes built from the line generator, each aimed at a path in
+ * tfc that may be slow or may buffer more than it should.
+ */
+
+static const Shape shapes[]{
+    { { "longline",  0, 4096, "n" },   ADD_EOL,   "a single line as long as the file" },
+    { { "noeol",     8, 40, "dum" },   STRIP_EOL, "no EOL after the last line" },
+    { { "cr",        8, 40, "c" },     NONE,      "bare CR line endings only" },
+    { { "alternate", 8, 40, "a" },     NONE,      "CRLF, LF and LFCR in turn on each line" },
+    { { "wide",   8192, 0, "du" },     NONE,      "lines of whitespace up to 8192 columns wide" },
+    { { "nul",       8, 40, "du" },    NUL,       "NUL bytes embedded in the lines" },
+    { { "empty",     0, 0, "u" },      NONE,      "nothing but empty lines" },
+};
+
+/**
+ * @brief Get the names of all the pathological shapes.
+ * 
+ * @return std::vector<std::string> the shape names.
+ */
+std::vector<std::string> shapeNames(void)
+{
+    std::vector<std::string> names{};
+    for (const auto & shape : shapes)
+        names.push_back(shape.profile.name);
+
+    return names;
+}
+
+/**
+ * @brief Look up a pathological shape by name.
+ * 
+ * @param name of the required shape.
+ * @return const Shape* the matching shape or nullptr if not found.
+ */
+const Shape * findShape(const std::string & name)
+{
+    for (const auto & shape : shapes)
+        if (name == shape.profile.name)
+            return &shape;
+
+    return nullptr;
+}
+
+/**
+ * @brief Stream a file of the given pathological shape to disk.
+ * 
+ * @param fileName of the file to generate.
+ * @param shape of the file.
+ * @param size minimum number of bytes to generate.
+ * @param seed for the line generator.
+ * @return int error value or 0 if no errors.
+ */
+int generateShape(const std::string & fileName, const Shape & shape, size_t size, uint64_t seed)
+{
+    return streamFile(fileName, shape.profile, size, seed, shape.fixup);
+}
+
+
+/**
+ * @section resumable generation command.
+ *
+ */
+
+/**
+ * @brief Command line entry point for generating a large fixture. Running
+ * the same command again after an interruption resumes the generation.
+ *
+ *   test generate file [--profile name | --shape name] [--size S] [--seed N]
+ *
+ * @param args command line arguments, starting with "generate".
+ * @return int error value or 0 if no errors.
+ */
+int generateCommand(const std::vector<std::string> & args)
+{
+    std::string fileName{};
+    std::string name{"all"};
+    size_t size{size_t{1} << 30};
+    uint64_t seed{1};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if ((args[i] == "--profile" || args[i] == "--shape") && value)
+            name = args[++i];
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--seed" && value)
+            invalid |= parseInt(args[++i], seed);
+        else if (fileName.empty() && args[i][0] != '-')
+            fileName = args[i];
+        else
+        {
+            std::cerr << "Unknown generate argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    const Profile * profile{findProfile(name)};
+    const Shape * shape{findShape(name)};
+    if (fileName.empty() || (!profile && !shape))
+    {
+        std::cerr << "generate needs a file name and a known profile or shape\n";
+
+        return 1;
+    }
+
+    return shape ? generateShape(fileName, *shape, size, seed) : generateFile(fileName, *profile, size, seed);
+}
+
+
 /**
  * Test environment set up.
  *
@@ -944,7 +1410,9 @@ int init(const std::string & root, const std::string & input, const std::string
     outputDir = output;
     expectedDir = expected;
 
-    deleteDirectory(root);
+    const double traceStart{traceClock()};
+    Stopwatch stopwatch{};
+    clearDirectory(root);
     createDirectory(input);
     createDirectory(output);
     createDirectory(expected);
@@ -963,5 +1431,12 @@ int init(const std::string & root, const std::string & input, const std::string
     tabToSpaceTests();
     optionsTests();
 
+    size_t bytes{};
+    for (const auto & dir : { input, expected })
+        for (const auto & entry : std::filesystem::directory_iterator{dir})
+            bytes += entry.file_size();
+    recordPhase(GENERATE, stopwatch.elapsed(), bytes);
+    traceEvent("fixtures", "generate", traceStart, { { "bytes", std::to_string(bytes) } });
+
     return 0;
 }
@@ -0,0 +1,94 @@
+/**
+ * @file    gen.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Test file generator interface for the 'tfc' utility.
+ */
+
+#if !defined(_GEN_H__20261017_0900__INCLUDED_)
+#define _GEN_H__20261017_0900__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/**
+ * @section large file generation interface.
+ *
+ * A Profile describes the shape of the lines streamed by generateFile().
+ * Each line gets a random indent of up to 'indent' spaces and tabs, a
+ * random body of up to 'length' characters and an EOL picked at random
+ * from 'eols' ('d'os, 'u'nix, 'm'alformed, bare 'c'arriage return, 'n'one,
+ * or 'a'lternating dos, unix and malformed on each line).
+ *
+ * Every 'checkpointInterval' bytes the generator state and the bytes
+ * written are saved in a journal beside the file. Generating the same file
+ * with the same profile, size and seed after an interruption resumes from
+ * the last checkpoint and gives the same bytes as an uninterrupted run.
+ */
+
+struct Profile
+{
+    const char * name;
+    size_t indent;
+    size_t length;
+    const char * eols;
+};
+
+extern const Profile * findProfile(const std::string & name);
+
+extern size_t checkpointInterval;
+
+extern int generateFile(const std::string & fileName, const Profile & profile, size_t size, uint64_t seed = 1);
+extern int interruptGeneration(const std::string & fileName, const Profile & profile, size_t size, size_t stop, uint64_t seed = 1);
+
+
+/**
+ * @section pathological file generation interface.
+ *
+ * A Shape is a Profile with a fixup applied to the streamed blocks, giving
+ * files such as a single huge line, no final EOL or embedded NUL bytes.
+ */
+
+enum Fixup { NONE, ADD_EOL, STRIP_EOL, NUL };
+
+struct Shape
+{
+    Profile profile;
+    Fixup fixup;
+    const char * description;
+};
+
+extern std::vector<std::string> shapeNames(void);
+extern const Shape * findShape(const std::string & name);
+extern int generateShape(const std::string & fileName, const Shape & shape, size_t size, uint64_t seed = 1);
+
+extern int generateCommand(const std::vector<std::string> & args);
+
+
+/**
+ * @section test environment set up.
+ *
+ */
+
+extern int init(const std::string & root, const std::string & input, const std::string & output, const std::string & expected);
+
+
+#endif // !defined(_GEN_H__20261017_0900__INCLUDED_)
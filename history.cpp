@@ -0,0 +1,512 @@
+/**
+ * @file    history.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Append-only CSV store of benchmark results and trend queries.
+ *
+ * The first line of the store names the columns, so columns can be added
+ * later without invalidating existing stores.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <cstdint>
+
+#include <sys/utsname.h>
+
+#include "bench.h"
+#include "history.h"
+
+/**
+ * @section basic utility code.
+ */
+
+const std::string defaultStore{"benchHistory.csv"};
+
+// Throughput differing from the median of the preceding runs by more than
+// this fraction is reported as a change point.
+static const double changeThreshold{0.10};
+static const size_t changeWindow{5};
+
+struct Column
+{
+    const char * name;
+    std::string (*get)(const Record &);
+    void (*set)(Record &, const std::string &);
+};
+
+static std::string str(double value)
+{
+    std::ostringstream os{};
+    os << std::setprecision(9) << value;
+
+    return os.str();
+}
+
+static const Column columns[]{
+    { "run",         [](const Record & r) { return r.run; },                  [](Record & r, const std::string & v) { r.run = v; } },
+    { "build",       [](const Record & r) { return r.build; },                [](Record & r, const std::string & v) { r.build = v; } },
+    { "host",        [](const Record & r) { return r.host; },                 [](Record & r, const std::string & v) { r.host = v; } },
+    { "options",     [](const Record & r) { return r.options; },              [](Record & r, const std::string & v) { r.options = v; } },
+    { "profile",     [](const Record & r) { return r.profile; },              [](Record & r, const std::string & v) { r.profile = v; } },
+    { "cache",       [](const Record & r) { return r.cache; },                [](Record & r, const std::string & v) { r.cache = v; } },
+    { "cpus",        [](const Record & r) { return r.cpus; },                 [](Record & r, const std::string & v) { r.cpus = v; } },
+    { "governor",    [](const Record & r) { return r.governor; },             [](Record & r, const std::string & v) { r.governor = v; } },
+    { "frequency",   [](const Record & r) { return str(r.frequency); },       [](Record & r, const std::string & v) { r.frequency = std::stod(v); } },
+    { "noise",       [](const Record & r) { return str(r.noise); },           [](Record & r, const std::string & v) { r.noise = std::stod(v); } },
+    { "size",        [](const Record & r) { return std::to_string(r.size); }, [](Record & r, const std::string & v) { r.size = std::stoull(v); } },
+    { "seconds",     [](const Record & r) { return str(r.seconds); },         [](Record & r, const std::string & v) { r.seconds = std::stod(v); } },
+    { "throughput",  [](const Record & r) { return str(r.throughput); },      [](Record & r, const std::string & v) { r.throughput = std::stod(v); } },
+    { "maxRss",      [](const Record & r) { return std::to_string(r.maxRss); },      [](Record & r, const std::string & v) { r.maxRss = std::stol(v); } },
+    { "user",        [](const Record & r) { return str(r.user); },            [](Record & r, const std::string & v) { r.user = std::stod(v); } },
+    { "system",      [](const Record & r) { return str(r.system); },          [](Record & r, const std::string & v) { r.system = std::stod(v); } },
+    { "minorFaults", [](const Record & r) { return std::to_string(r.minorFaults); }, [](Record & r, const std::string & v) { r.minorFaults = std::stol(v); } },
+    { "majorFaults", [](const Record & r) { return std::to_string(r.majorFaults); }, [](Record & r, const std::string & v) { r.majorFaults = std::stol(v); } },
+    { "voluntary",   [](const Record & r) { return std::to_string(r.voluntary); },   [](Record & r, const std::string & v) { r.voluntary = std::stol(v); } },
+    { "involuntary", [](const Record & r) { return std::to_string(r.involuntary); }, [](Record & r, const std::string & v) { r.involuntary = std::stol(v); } },
+    { "rchar",       [](const Record & r) { return std::to_string(r.rchar); },       [](Record & r, const std::string & v) { r.rchar = std::stoull(v); } },
+    { "wchar",       [](const Record & r) { return std::to_string(r.wchar); },       [](Record & r, const std::string & v) { r.wchar = std::stoull(v); } },
+    { "syscr",       [](const Record & r) { return std::to_string(r.syscr); },       [](Record & r, const std::string & v) { r.syscr = std::stoull(v); } },
+    { "syscw",       [](const Record & r) { return std::to_string(r.syscw); },       [](Record & r, const std::string & v) { r.syscw = std::stoull(v); } },
+    { "readBytes",   [](const Record & r) { return std::to_string(r.readBytes); },   [](Record & r, const std::string & v) { r.readBytes = std::stoull(v); } },
+    { "writeBytes",  [](const Record & r) { return std::to_string(r.writeBytes); },  [](Record & r, const std::string & v) { r.writeBytes = std::stoull(v); } },
+};
+
+/**
+ * @brief Quote a CSV field if it contains a separator or quote.
+ */
+static std::string quote(const std::string & field)
+{
+    if (field.find_first_of(",\"\n") == std::string::npos)
+        return field;
+
+    std::string quoted{"\""};
+    for (const auto c : field)
+    {
+        if (c == '"')
+            quoted += '"';
+        quoted += c;
+    }
+
+    return quoted + '"';
+}
+
+/**
+ * @brief Split a CSV line into fields, honouring quoted fields.
+ */
+static std::vector<std::string> split(const std::string & line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted{};
+    for (size_t i = 0; i < line.length(); ++i)
+    {
+        const char c{line[i]};
+        if (quoted && c == '"' && i + 1 < line.length() && line[i + 1] == '"')
+            fields.back() += line[++i];
+        else if (c == '"')
+            quoted = !quoted;
+        else if (!quoted && c == ',')
+            fields.emplace_back();
+        else
+            fields.back() += c;
+    }
+
+    return fields;
+}
+
+
+/**
+ * @section run identification.
+ *
+ */
+
+/**
+ * @brief Generate the UTC timestamp that identifies a benchmark run.
+ *
+ * @return std::string ISO 8601 timestamp.
+ */
+std::string runStamp(void)
+{
+    const std::time_t now{std::time(nullptr)};
+    std::tm utc{};
+    gmtime_r(&now, &utc);
+
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    return buffer;
+}
+
+/**
+ * @brief Describe the host: node name, kernel, architecture, CPU model and
+ * number of hardware threads.
+ *
+ * @return std::string host description.
+ */
+std::string hostInfo(void)
+{
+    std::string info{};
+    utsname name{};
+    if (uname(&name) == 0)
+        info = std::string{name.nodename} + ' ' + name.sysname + ' ' + name.release + ' ' + name.machine;
+
+    if (std::ifstream is{"/proc/cpuinfo"})
+    {
+        std::string line;
+        while (getline(is, line))
+            if (line.compare(0, 10, "model name") == 0)
+            {
+                const auto pos{line.find(": ")};
+                if (pos != std::string::npos)
+                    info += ' ' + line.substr(pos + 2);
+                break;
+            }
+    }
+
+    return info + " x" + std::to_string(std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Identify the build of a program by hashing its executable.
+ *
+ * @param program name, looked up on PATH if it does not contain a '/'.
+ * @return std::string 64 bit FNV-1a hash of the executable as hex, or
+ * "unknown" if it could not be found.
+ */
+std::string buildId(const std::string & program)
+{
+    namespace fs = std::filesystem;
+
+    fs::path path{program};
+    if (program.find('/') == std::string::npos)
+    {
+        path.clear();
+        std::istringstream dirs{getenv("PATH") ? getenv("PATH") : ""};
+        for (std::string dir; getline(dirs, dir, ':'); )
+            if (fs::exists(dir + '/' + program))
+            {
+                path = dir + '/' + program;
+                break;
+            }
+    }
+
+    std::ifstream is{path, std::ios::binary|std::ios::in};
+    if (path.empty() || !is)
+        return "unknown";
+
+    uint64_t hash{0xcbf29ce484222325ULL};
+    char buffer[1 << 16];
+    while (is.read(buffer, sizeof(buffer)) || is.gcount())
+        for (std::streamsize i = 0; i < is.gcount(); ++i)
+        {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 0x100000001b3ULL;
+        }
+
+    std::ostringstream os{};
+    os << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    return os.str();
+}
+
+
+/**
+ * @section record storage.
+ *
+ */
+
+static std::string header(void)
+{
+    std::string line{};
+    for (const auto & column : columns)
+        line += (line.empty() ? "" : ",") + std::string{column.name};
+
+    return line;
+}
+
+static void writeRecord(std::ostream & os, const Record & record)
+{
+    const char * separator{""};
+    for (const auto & column : columns)
+    {
+        os << separator << quote(column.get(record));
+        separator = ",";
+    }
+    os << '\n';
+}
+
+/**
+ * @brief Read all records from the store, counting the lines that could not
+ * be read and the columns that are no longer known.
+ *
+ * @return int error value or 0 if no errors.
+ */
+static int loadStore(const std::string & fileName, std::vector<Record> & records, size_t & damaged, size_t & unknown)
+{
+    damaged = unknown = 0;
+    if (std::ifstream is{fileName, std::ios::in})
+    {
+        std::string line;
+        if (!getline(is, line))
+            return 0;
+
+        std::vector<const Column *> order{};
+        for (const auto & name : split(line))
+        {
+            const auto it{std::find_if(std::begin(columns), std::end(columns), [&name](const Column & c) { return name == c.name; })};
+            order.push_back(it == std::end(columns) ? nullptr : it);
+            if (it == std::end(columns))
+                ++unknown;
+        }
+
+        while (getline(is, line))
+        {
+            if (line.empty())
+                continue;
+
+            const auto fields{split(line)};
+            Record record{};
+            try
+            {
+                for (size_t i = 0; i < fields.size() && i < order.size(); ++i)
+                    if (order[i] && !fields[i].empty())
+                        order[i]->set(record, fields[i]);
+            }
+            catch (...)
+            {
+                ++damaged;  // A damaged line, e.g. from an interrupted run.
+                continue;
+            }
+            records.push_back(record);
+        }
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Rewrite a store written with different columns with the current
+ * columns. The new store is written beside the old one and renamed over
+ * it, so an interruption leaves one or the other. A store with lines that
+ * cannot be read, or with columns that are no longer known, is left alone
+ * rather than losing those measurements.
+ *
+ * @param fileName of the store.
+ * @return int error value or 0 if no errors.
+ */
+static int migrateStore(const std::string & fileName)
+{
+    std::vector<Record> existing{};
+    size_t damaged{};
+    size_t unknown{};
+    if (loadStore(fileName, existing, damaged, unknown))
+        return 1;
+
+    if (damaged || unknown)
+    {
+        std::cerr << "Unable to migrate " << fileName << " to the current columns, it has " << damaged << " damaged line(s) and "
+            << unknown << " unknown column(s). Move it aside to start a new store.\n";
+
+        return 1;
+    }
+
+    const std::string tempFileName{fileName + ".tmp"};
+    {
+        std::ofstream os{tempFileName, std::ios::out|std::ios::trunc};
+        if (!os)
+            return 1;
+
+        os << header() << '\n';
+        for (const auto & record : existing)
+            writeRecord(os, record);
+        if (!os.flush())
+            return 1;
+    }
+
+    std::error_code ec{};
+    std::filesystem::rename(tempFileName, fileName, ec);
+
+    return ec ? 1 : 0;
+}
+
+/**
+ * @brief Append records to the store, creating it with a header line if
+ * it does not exist. A store written with different columns is first
+ * migrated to the current columns, so that no field is lost.
+ *
+ * @param fileName of the store.
+ * @param records to append.
+ * @return int error value or 0 if no errors.
+ */
+int appendRecords(const std::string & fileName, const std::vector<Record> & records)
+{
+    const bool create{!std::filesystem::exists(fileName)};
+    if (!create)
+    {
+        std::string line{};
+        if (std::ifstream is{fileName, std::ios::in})
+            getline(is, line);
+
+        if ((line != header()) && migrateStore(fileName))
+            return 1;
+    }
+
+    if (std::ofstream os{fileName, std::ios::out|std::ios::app})
+    {
+        if (create)
+            os << header() << '\n';
+
+        for (const auto & record : records)
+            writeRecord(os, record);
+
+        return os ? 0 : 1;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Read all records from the store. Columns are matched by name,
+ * unknown columns are ignored and damaged lines are skipped.
+ *
+ * @param fileName of the store.
+ * @param records read from the store.
+ * @return int error value or 0 if no errors.
+ */
+int readRecords(const std::string & fileName, std::vector<Record> & records)
+{
+    size_t damaged{};
+    size_t unknown{};
+
+    return loadStore(fileName, records, damaged, unknown);
+}
+
+/**
+ * @section trend queries.
+ *
+ */
+
+/**
+ * @brief Print the throughput trend of each benchmark case over the last N
+ * runs, and the runs where the throughput changed.
+ *
+ *   test history [runs] [--store file]
+ *
+ * @param args command line arguments, starting with "history".
+ * @return int error value or 0 if no errors.
+ */
+int historyCommand(const std::vector<std::string> & args)
+{
+    std::string fileName{defaultStore};
+    size_t count{10};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        if (args[i] == "--store" && i + 1 < args.size())
+            fileName = args[++i];
+        else if (std::isdigit(static_cast<unsigned char>(args[i][0])))
+            invalid |= parseInt(args[i], count);
+        else
+        {
+            std::cerr << "Unknown history argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    std::vector<Record> records{};
+    if (readRecords(fileName, records))
+    {
+        std::cerr << "Unable to read " << fileName << '\n';
+
+        return 1;
+    }
+
+    // Keep only the records of the last 'count' runs.
+    std::vector<std::string> runs{};
+    for (const auto & record : records)
+        if (runs.empty() || runs.back() != record.run)
+            runs.push_back(record.run);
+    if (runs.size() > count)
+        runs.erase(runs.begin(), runs.end() - count);
+
+    std::vector<std::string> keys{};
+    std::vector<std::vector<const Record *>> series{};
+    for (const auto & record : records)
+    {
+        if (std::find(runs.begin(), runs.end(), record.run) == runs.end())
+            continue;
+
+        std::string key{"tfc " + record.options + " on " + record.profile + " (" + std::to_string(record.size) + " bytes)"};
+        if (record.cache == "cold")
+            key += " with a cold cache";
+        const auto it{std::find(keys.begin(), keys.end(), key)};
+        if (it == keys.end())
+        {
+            keys.push_back(key);
+            series.push_back({&record});
+        }
+        else
+            series[it - keys.begin()].push_back(&record);
+    }
+
+    std::cout << "\nThroughput (MiB/s) over the last " << runs.size() << " runs in " << fileName << ".\n";
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t k = 0; k < keys.size(); ++k)
+    {
+        const auto & points{series[k]};
+        std::cout << '\n' << keys[k] << ":\n ";
+        for (const auto point : points)
+            std::cout << ' ' << point->throughput;
+        std::cout << '\n';
+
+        const double first{points.front()->throughput};
+        const double last{points.back()->throughput};
+        if (first > 0)
+            std::cout << "  trend " << std::showpos << (100 * (last - first) / first) << std::noshowpos << "% from first to last run\n";
+
+        for (size_t i = 1; i < points.size(); ++i)
+        {
+            std::vector<double> previous{};
+            for (size_t j = (i > changeWindow) ? i - changeWindow : 0; j < i; ++j)
+                previous.push_back(points[j]->throughput);
+
+            const double reference{median(previous)};
+            const double change{reference > 0 ? (points[i]->throughput - reference) / reference : 0};
+            if (std::abs(change) > changeThreshold)
+                std::cout << "  changed " << std::showpos << (100 * change) << std::noshowpos << "% at run " << points[i]->run
+                    << " build " << points[i]->build << (points[i]->build != points[i - 1]->build ? " (new build)" : "") << '\n';
+        }
+    }
+
+    return 0;
+}
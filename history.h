@@ -0,0 +1,80 @@
+/**
+ * @file    history.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Append-only CSV store of benchmark results and trend queries.
+ */
+
+#if !defined(_HISTORY_H__20261017_1030__INCLUDED_)
+#define _HISTORY_H__20261017_1030__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section benchmark history interface.
+ *
+ * One Record is stored per benchmark case per run. All records of a run
+ * share the same 'run' timestamp.
+ */
+
+struct Record
+{
+    std::string run;
+    std::string build;
+    std::string host;
+    std::string options;
+    std::string profile;
+    std::string cache;      // "warm" or "cold" page cache for the input.
+    std::string cpus;       // CPU list the run was pinned to, empty for all.
+    std::string governor;   // cpufreq governor of the first CPU used.
+    double frequency{};     // MHz of the first CPU used, after the run.
+    double noise{};         // Relative spread of the repeated runs.
+    size_t size{};
+    double seconds{};
+    double throughput{};    // MiB per second.
+    long maxRss{};          // KiB.
+    double user{};
+    double system{};
+    long minorFaults{};
+    long majorFaults{};
+    long voluntary{};
+    long involuntary{};
+    size_t rchar{};
+    size_t wchar{};
+    size_t syscr{};
+    size_t syscw{};
+    size_t readBytes{};
+    size_t writeBytes{};
+};
+
+extern const std::string defaultStore;
+
+extern std::string runStamp(void);
+extern std::string hostInfo(void);
+extern std::string buildId(const std::string & program);
+
+extern int appendRecords(const std::string & fileName, const std::vector<Record> & records);
+extern int readRecords(const std::string & fileName, std::vector<Record> & records);
+
+extern int historyCommand(const std::vector<std::string> & args);
+
+
+#endif // !defined(_HISTORY_H__20261017_1030__INCLUDED_)
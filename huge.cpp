@@ -0,0 +1,352 @@
+/**
+ * @file    huge.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Correctness and throughput of tfc on files beyond 32-bit limits.
+ *
+ * Throughput of conversions is sampled from the growth of the output file
+ * while tfc runs, giving the rate before and after the output passes 4 GiB.
+ * A summary writes nothing until the end, so only its overall rate is shown.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "fuzz.h"
+#include "results.h"
+#include "summary.h"
+#include "huge.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const size_t boundary{size_t{1} << 32};
+
+// Throughput above the boundary below this fraction of the rate before it
+// is marked.
+static const double minimumRatio{0.75};
+
+static const std::vector<std::string> tileNames{ "lines", "bytes" };
+static const std::vector<std::string> hugeOptions{ "-x", "-s -d", "-t -u -8" };
+
+// 6 lines in 13 bytes covering every line beginning and line ending.
+static const std::string linesTile{"\n \n\t\r\n \t\nx\n\n\r"};
+
+struct Sample
+{
+    double seconds;
+    size_t bytes;
+};
+
+/**
+ * @brief Get the tile repeated to make a huge file. A tile never starts
+ * with a CR, so that a malformed LFCR is not formed across a join.
+ */
+static std::string makeTile(const std::string & dir, const std::string & name)
+{
+    if (name == "lines")
+        return linesTile;
+
+    if (name != "bytes")
+        return std::string{};
+
+    const std::string fileName{dir + "/hugeTile.txt"};
+    std::string tile{};
+    if (!generateFile(fileName, *findProfile("all"), 64 << 10))
+    {
+        std::ifstream is{fileName, std::ios::binary};
+        std::ostringstream os{};
+        os << is.rdbuf();
+        tile = os.str();
+    }
+    std::filesystem::remove(fileName);
+    if (!tile.empty() && tile[0] == '\r')
+        tile.insert(0, 1, 'x');
+
+    return tile;
+}
+
+static std::string readFile(const std::string & fileName)
+{
+    std::ifstream is{fileName, std::ios::binary};
+    std::ostringstream os{};
+    os << is.rdbuf();
+
+    return os.str();
+}
+
+/**
+ * @brief Check a file is exactly 'count' copies of 'tile', reading it a
+ * block at a time.
+ *
+ * @param fileName of the file to check.
+ * @param tile expected to be repeated.
+ * @param count of repeats expected.
+ * @param offset set to the first differing byte offset.
+ * @return true if the file matched, false for an empty tile.
+ */
+static bool verifyTiled(const std::string & fileName, const std::string & tile, size_t count, size_t & offset)
+{
+    offset = 0;
+    if (tile.empty())
+        return false;
+
+    std::string block{};
+    while (block.size() < (1 << 20))
+        block += tile;
+
+    std::ifstream is{fileName, std::ios::binary};
+    std::vector<char> buffer(block.size());
+    const size_t expected{count * tile.size()};
+    for (offset = 0; is; )
+    {
+        is.read(buffer.data(), buffer.size());
+        const size_t got = is.gcount();
+        const size_t length{std::min(got, expected - std::min(expected, offset))};
+        if (std::memcmp(buffer.data(), block.data(), length))
+        {
+            for (size_t i = 0; i < length; ++i, ++offset)
+                if (buffer[i] != block[i])
+                    return false;
+        }
+        offset += length;
+        if (length < got)
+            return false;
+    }
+
+    return offset == expected;
+}
+
+/**
+ * @brief Run a tfc command while sampling the size of its output file.
+ *
+ * @return int exit status of the command.
+ */
+static int runSampled(const std::string & command, const std::string & outputFileName, Usage & usage, std::vector<Sample> & samples)
+{
+    std::atomic<bool> done{};
+    std::thread sampler{[&]()
+    {
+        Stopwatch stopwatch{};
+        while (!done)
+        {
+            std::error_code ec{};
+            const size_t bytes = std::filesystem::file_size(outputFileName, ec);
+            if (!ec)
+                samples.push_back(Sample{stopwatch.elapsed(), bytes});
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }};
+
+    const int status{spawn(command, usage)};
+    done = true;
+    sampler.join();
+
+    return status;
+}
+
+/**
+ * @brief Work out the throughput before and after the output passed the
+ * boundary from the samples of its size.
+ */
+static void boundaryRates(const std::vector<Sample> & samples, double & below, double & above)
+{
+    below = above = 0;
+    for (size_t i = 1; i < samples.size(); ++i)
+        if (samples[i].bytes >= boundary)
+        {
+            const auto & first{samples.front()};
+            const auto & cross{samples[i]};
+            const auto & last{samples.back()};
+            if (cross.seconds > first.seconds)
+                below = (cross.bytes - first.bytes) / static_cast<double>(MiB) / (cross.seconds - first.seconds);
+            if (last.seconds > cross.seconds)
+                above = (last.bytes - cross.bytes) / static_cast<double>(MiB) / (last.seconds - cross.seconds);
+
+            return;
+        }
+}
+
+
+/**
+ * @section huge file implementation.
+ *
+ */
+
+std::vector<std::string> hugeTileNames(void)
+{
+    return tileNames;
+}
+
+/**
+ * @brief Tile a huge file and check tfc's output or summary for each set
+ * of options matches the tile result repeated, reporting the throughput.
+ *
+ * @param dir working directory for the generated files.
+ * @param tile name of the tile, "lines" or "bytes".
+ * @param optionSets tfc options to check.
+ * @param size minimum size of the huge file in bytes.
+ * @return int the number of option sets that failed.
+ */
+int hugeCheck(const std::string & dir, const std::string & tile, const std::vector<std::string> & optionSets, size_t size)
+{
+    std::filesystem::create_directories(dir);
+    const std::string pattern{makeTile(dir, tile)};
+    if (pattern.empty())
+    {
+        std::cerr << "Unknown tile " << tile << '\n';
+
+        return 1;
+    }
+
+    const std::string tileFileName{dir + "/hugeTile.txt"};
+    const std::string tileOutFileName{dir + "/hugeTileOut.txt"};
+    const std::string inputFileName{dir + "/huge.txt"};
+    const std::string outputFileName{dir + "/hugeOut.txt"};
+
+    std::cout << "Generating " << tile << " file " << inputFileName << " (" << size << " bytes)\n";
+    if (std::ofstream os{tileFileName, std::ios::binary|std::ios::out})
+        os << pattern;
+    if (tileFile(inputFileName, pattern, size))
+        return 1;
+
+    const size_t bytes = std::filesystem::file_size(inputFileName);
+    const size_t count{bytes / pattern.size()};
+    int failed{};
+    for (const auto & options : optionSets)
+    {
+        const bool summary{options.find("-x") != std::string::npos};
+        Usage usage{};
+        if (spawn(tfcPath + " " + options + " -i " + tileFileName + " -o " + tileOutFileName, usage))
+        {
+            std::cout << std::setw(6) << tile << std::setw(10) << options << "  tfc failed on the tile\n";
+            ++failed;
+            continue;
+        }
+        const std::string tileOut{readFile(tileOutFileName)};
+
+        std::vector<Sample> samples{};
+        const int status{runSampled(tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName,
+            outputFileName, usage, samples)};
+
+        std::string result{"identical"};
+        if (status)
+            result = "tfc exit status " + std::to_string(status);
+        else if (summary)
+        {
+            std::string path{};
+            Summary tileSummary{};
+            Summary actual{};
+            if (parseSummary(tileOut, path, tileSummary) || parseSummary(readFile(outputFileName), path, actual))
+                result = "unable to parse summary";
+            else if (actual != tileSummary * count)
+                result = summaryDifferences(actual, tileSummary * count);
+        }
+        else
+        {
+            size_t offset{};
+            if (!verifyTiled(outputFileName, tileOut, count, offset))
+                result = "DIFFERENT at byte " + std::to_string(offset);
+        }
+
+        double below{};
+        double above{};
+        boundaryRates(samples, below, above);
+        const bool slower{below && above && (above < minimumRatio * below)};
+        std::cout << std::setw(6) << tile << std::setw(10) << options << std::setw(14) << bytes
+            << std::setw(12) << count * std::count(pattern.begin(), pattern.end(), '\n')
+            << std::fixed << std::setprecision(1) << std::setw(10) << (usage.elapsed ? bytes / static_cast<double>(MiB) / usage.elapsed : 0)
+            << std::setw(10) << below << std::setw(10) << above << (slower ? " slower" : "       ")
+            << "  " << result << '\n';
+
+        if (result != "identical")
+            ++failed;
+        std::filesystem::remove(outputFileName);
+    }
+
+    std::filesystem::remove(tileFileName);
+    std::filesystem::remove(tileOutFileName);
+    std::filesystem::remove(inputFileName);
+
+    return failed;
+}
+
+/**
+ * @brief Command line entry point for the huge file checks.
+ *
+ *   test huge [--size S] [--tile lines|bytes]... [--options o]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "huge".
+ * @return int error value or 0 if no errors.
+ */
+int hugeCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t size{(size_t{9} << 30) / 2};
+    std::vector<std::string> tiles{};
+    std::vector<std::string> optionSets{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--tile" && value)
+            tiles.push_back(args[++i]);
+        else if (args[i] == "--options" && value)
+            optionSets.push_back(args[++i]);
+        else
+        {
+            std::cerr << "Unknown huge argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (tiles.empty())
+        tiles = tileNames;
+    if (optionSets.empty())
+        optionSets = hugeOptions;
+
+    std::cout << "\nHuge file checks on " << size << " byte files, input MiB/s overall and output MiB/s before and after 4 GiB of output.\n";
+    std::cout << std::setw(6) << "Tile" << std::setw(10) << "Options" << std::setw(14) << "Bytes" << std::setw(12) << "Lines"
+        << std::setw(10) << "MiB/s" << std::setw(10) << "< 4 GiB" << std::setw(10) << "> 4 GiB" << "         Output\n";
+
+    int failed{};
+    for (const auto & tile : tiles)
+        failed += hugeCheck(dir, tile, optionSets, size);
+
+    if (failed)
+        std::cout << failed << " huge file check(s) failed.\n";
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+/**
+ * @file    huge.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Correctness and throughput of tfc on files beyond 32-bit limits.
+ */
+
+#if !defined(_HUGE_H__20261017_1630__INCLUDED_)
+#define _HUGE_H__20261017_1630__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section huge file interface.
+ *
+ * A huge input is a small line aligned tile repeated to 'size' bytes, so
+ * the expected output is the tfc output for the tile repeated the same
+ * number of times and the expected summary is the tile summary multiplied
+ * up. Both are verified a block at a time, the harness never holds the
+ * huge file. The "lines" tile has an average line length under 2 bytes, so
+ * a file over 4 GiB also has over 2^31 lines, and the "bytes" tile is
+ * generated from the "all" profile.
+ */
+
+extern std::vector<std::string> hugeTileNames(void);
+extern int hugeCheck(const std::string & dir, const std::string & tile, const std::vector<std::string> & optionSets, size_t size);
+extern int hugeCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_HUGE_H__20261017_1630__INCLUDED_)
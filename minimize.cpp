@@ -0,0 +1,403 @@
+/**
+ * @file    minimize.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Delta debugging minimizer for inputs on which tfc fails or is slow.
+ *
+ * This is Zeller's ddmin: the input is split into n chunks and each chunk
+ * and then each complement is tried, in parallel, falling back to finer
+ * chunks when none is interesting. Each worker has its own directory.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <filesystem>
+
+#include "spawn.h"
+#include "bench.h"
+#include "fuzz.h"
+#include "trace.h"
+#include "results.h"
+#include "minimize.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// Byte level minimization is skipped for inputs still larger than this
+// after the line level pass. A pass at the finest granularity builds and
+// writes twice as many candidates as there are bytes, each nearly the size
+// of the input, so its cost grows with the square of this.
+static const size_t maxByteUnits{1 << 16};
+
+static const size_t memoryLimit{256 << 20};
+
+using Units = std::vector<std::string>;
+
+// The units from..to of a candidate, or all but those for a complement.
+struct Candidate
+{
+    size_t from;
+    size_t to;
+    bool complement;
+};
+
+static std::string join(const Units & units, size_t from, size_t to, bool complement)
+{
+    std::string joined{};
+    for (size_t i = 0; i < units.size(); ++i)
+        if (complement != (i >= from && i < to))
+            joined += units[i];
+
+    return joined;
+}
+
+static Units splitLines(const std::string & input)
+{
+    Units lines{};
+    size_t start{};
+    for (size_t pos = input.find('\n'); pos != std::string::npos; pos = input.find('\n', start))
+    {
+        lines.push_back(input.substr(start, pos + 1 - start));
+        start = pos + 1;
+    }
+    if (start < input.size())
+        lines.push_back(input.substr(start));
+
+    return lines;
+}
+
+static Units splitBytes(const std::string & input)
+{
+    Units bytes{};
+    for (const auto c : input)
+        bytes.push_back(std::string{c});
+
+    return bytes;
+}
+
+static bool writeFile(const std::string & fileName, const std::string & content)
+{
+    std::ofstream os{fileName, std::ios::binary|std::ios::out};
+
+    return static_cast<bool>(os.write(content.data(), content.size()));
+}
+
+/**
+ * @brief Test candidates in parallel and return the index of the first one
+ * that is interesting. Workers stop taking candidates once one is found.
+ * Each worker joins its candidate's units just before testing it, so no
+ * more than 'jobs' candidates are held at once.
+ *
+ * @return size_t the index, or candidates.size() if none is interesting.
+ */
+static size_t firstInteresting(const std::string & dir, const Predicate & predicate, const Units & units, const std::vector<Candidate> & candidates, int jobs)
+{
+    std::vector<char> results(candidates.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> found{false};
+
+    Stopwatch clock{};
+    std::vector<std::thread> workers{};
+    for (int w = 0; w < jobs; ++w)
+        workers.emplace_back([&, w]()
+        {
+            traceThreadName("minimizer " + std::to_string(w));
+            suppressPhases();
+            const std::string workerDir{dir + "/min" + std::to_string(w)};
+            std::filesystem::create_directories(workerDir);
+            for (size_t i = next++; !found && (i < candidates.size()); i = next++)
+            {
+                const auto & [from, to, complement] = candidates[i];
+                if ((results[i] = interesting(workerDir, predicate, join(units, from, to, complement))))
+                    found = true;
+            }
+        });
+    for (auto & worker : workers)
+        worker.join();
+    recordPhase(EXECUTE, clock.elapsed());
+
+    return std::find(results.begin(), results.end(), 1) - results.begin();
+}
+
+/**
+ * @brief Reduce a list of units with ddmin.
+ *
+ * @return Units the reduced list, still interesting when joined.
+ */
+static Units ddmin(const std::string & dir, const Predicate & predicate, Units units, int jobs, const char * level)
+{
+    size_t n{2};
+    while (units.size() >= 2)
+    {
+        const size_t chunk{(units.size() + n - 1) / n};
+        std::vector<Candidate> candidates{};
+        for (size_t from = 0; from < units.size(); from += chunk)
+            candidates.push_back(Candidate{from, std::min(from + chunk, units.size()), false});    // Subsets.
+        const size_t subsets{candidates.size()};
+        if (subsets > 2)
+            for (size_t i = 0; i < subsets; ++i)
+                candidates.push_back(Candidate{candidates[i].from, candidates[i].to, true});        // Complements.
+
+        const size_t i{firstInteresting(dir, predicate, units, candidates, jobs)};
+        if (i < subsets)
+        {
+            const auto & [from, to, complement] = candidates[i];
+            units = Units(units.begin() + from, units.begin() + to);
+            n = 2;
+        }
+        else if (i < candidates.size())
+        {
+            const auto & [from, to, complement] = candidates[i];
+            units.erase(units.begin() + from, units.begin() + to);
+            n = std::max<size_t>(n - 1, 2);
+        }
+        else if (n < units.size())
+            n = std::min(2 * n, units.size());
+        else
+            break;
+
+        std::cout << "  " << level << ": " << units.size() << " left\n";
+    }
+
+    return units;
+}
+
+static std::string escapeChar(char c)
+{
+    switch (c)
+    {
+    case '\t': return "'\\t'";
+    case '\r': return "'\\r'";
+    case '\n': return "'\\n'";
+    case '\0': return "'\\0'";
+    case '\\': return "'\\\\'";
+    case '\'': return "'\\''";
+    }
+
+    if (static_cast<unsigned char>(c) < ' ' || static_cast<unsigned char>(c) > '~')
+    {
+        std::ostringstream os{};
+        os << "'\\x" << std::hex << (static_cast<unsigned>(c) & 0xff) << "'";
+
+        return os.str();
+    }
+
+    return std::string{'\'', c, '\''};
+}
+
+
+/**
+ * @section minimizer implementation.
+ *
+ */
+
+/**
+ * @brief Check whether an input is interesting to the predicate.
+ *
+ * @param dir working directory, not shared with any other thread.
+ * @param predicate to apply.
+ * @param input to test.
+ * @return true if the input is interesting.
+ */
+bool interesting(const std::string & dir, const Predicate & predicate, const std::string & input)
+{
+    if (input.empty())
+        return false;
+
+    if (predicate.kind == Predicate::SLOW)
+    {
+        const Cost cost{measureCost(dir, input, predicate.options, predicate.size, predicate.timeout)};
+
+        return cost.timedOut || (!cost.status && cost.wall > predicate.budget);
+    }
+
+    const std::string inputFileName{dir + "/min.txt"};
+    const std::string outputFileName{dir + "/minOut.txt"};
+    const std::string oracleFileName{dir + "/minOracle.txt"};
+    if (!writeFile(inputFileName, input))
+        return false;
+
+    const Limits limits{memoryLimit, predicate.timeout};
+    Usage usage{};
+    const int status{spawn(tfcPath + " " + predicate.options + " -i " + inputFileName + " -o " + outputFileName, usage, limits)};
+    if (predicate.kind == Predicate::FAILS)
+        return status || usage.timedOut;
+
+    Usage oracleUsage{};
+    const int oracleStatus{spawn(predicate.oracle + " " + predicate.options + " -i " + inputFileName + " -o " + oracleFileName, oracleUsage, limits)};
+    if (status != oracleStatus)
+        return true;
+
+    return !status && !sameContent(outputFileName, oracleFileName);
+}
+
+/**
+ * @brief Minimize an interesting input, first by lines and then by bytes.
+ *
+ * @param dir working directory for the candidate files.
+ * @param predicate the input must still satisfy.
+ * @param input to minimize.
+ * @param jobs number of candidates tested in parallel.
+ * @return std::string the minimized input.
+ */
+std::string minimize(const std::string & dir, const Predicate & predicate, const std::string & input, int jobs)
+{
+    Units units{ddmin(dir, predicate, splitLines(input), jobs, "lines")};
+    std::string reduced{join(units, 0, 0, true)};
+
+    if (reduced.size() <= maxByteUnits)
+        reduced = join(ddmin(dir, predicate, splitBytes(reduced), jobs, "bytes"), 0, 0, true);
+
+    return reduced;
+}
+
+/**
+ * @brief Express an input as a fixture in the style of gen.cpp.
+ *
+ * @param name of the fixture, such as "testMin1".
+ * @param input content of the fixture.
+ * @param comment describing the fixture.
+ * @return std::string C++ code that writes the fixture to the input directory.
+ */
+std::string fixtureCode(const std::string & name, const std::string & input, const std::string & comment)
+{
+    std::ostringstream os{};
+    os << "/* " << comment << "\ntestdata/input/" << name << ".txt\n*/\n";
+    os << "    std::vector<char> " << name << "{ \n        ";
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        os << escapeChar(input[i]);
+        if (i + 1 < input.size())
+            os << ((input[i] == '\n') ? ", \n        " : ", ");
+    }
+    os << " \n    };\n";
+    os << "    filename = \"/" << name << ".txt\";\n";
+    os << "    input.setFileName(inputDir + filename);\n";
+    os << "    input.write(" << name << ");\n";
+
+    return os.str();
+}
+
+/**
+ * @brief Command line entry point for the minimizer.
+ *
+ *   test minimize file --options "opts" [--oracle path | --slow ns] [--size S]
+ *                 [--timeout secs] [--jobs N] [--name fixture] [--fixture file]
+ *
+ * @param dir working directory for the candidate files.
+ * @param args command line arguments, starting with "minimize".
+ * @return int error value or 0 if no errors.
+ */
+int minimizeCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    if (args.size() < 2)
+    {
+        std::cerr << "An input file to minimize is needed.\n";
+
+        return 1;
+    }
+
+    Predicate predicate{};
+    int jobs{static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))};
+    std::string name{"testMin1"};
+    std::string fixtureFileName{};
+    int invalid{};
+    for (size_t i = 2; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--options" && value)
+            predicate.options = args[++i];
+        else if (args[i] == "--oracle" && value)
+        {
+            predicate.kind = Predicate::DIFFERS;
+            predicate.oracle = args[++i];
+        }
+        else if (args[i] == "--slow" && value)
+        {
+            predicate.kind = Predicate::SLOW;
+            invalid |= parseDouble(args[++i], predicate.budget, 0);
+        }
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], predicate.size);
+        else if (args[i] == "--timeout" && value)
+            invalid |= parseDouble(args[++i], predicate.timeout, 0);
+        else if (args[i] == "--jobs" && value)
+            invalid |= parseInt(args[++i], jobs, 1);
+        else if (args[i] == "--name" && value)
+            name = args[++i];
+        else if (args[i] == "--fixture" && value)
+            fixtureFileName = args[++i];
+        else
+        {
+            std::cerr << "Unknown minimize argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    std::ifstream is{args[1], std::ios::binary};
+    const std::string input{std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{}};
+
+    // The first worker's directory is used for the initial check, so that
+    // every candidate file is removed with the worker directories.
+    auto removeWorkers = [&]()
+    {
+        for (int w = 0; w < jobs; ++w)
+            std::filesystem::remove_all(dir + "/min" + std::to_string(w));
+    };
+    const std::string checkDir{dir + "/min0"};
+    std::filesystem::create_directories(checkDir);
+    if (!interesting(checkDir, predicate, input))
+    {
+        std::cerr << args[1] << " is not interesting, nothing to minimize.\n";
+        removeWorkers();
+
+        return 1;
+    }
+
+    std::cout << "\nMinimizing " << args[1] << " (" << input.size() << " bytes) with " << jobs << " jobs.\n";
+    const std::string reduced{minimize(dir, predicate, input, jobs)};
+    removeWorkers();
+    std::cout << "Minimized to " << reduced.size() << " bytes.\n";
+
+    const char * reason{predicate.kind == Predicate::SLOW ? "exceeds the time budget when tiled" :
+        predicate.kind == Predicate::DIFFERS ? "gives different output from the oracle" : "fails"};
+    const std::string comment{"Minimized from " + args[1] + ", 'tfc " + predicate.options + "' " + reason + "."};
+    const std::string code{fixtureCode(name, reduced, comment)};
+    if (fixtureFileName.empty())
+        std::cout << '\n' << code;
+    else if (std::ofstream os{fixtureFileName, std::ios::out})
+        os << code;
+    else
+    {
+        std::cerr << "Unable to write " << fixtureFileName << '\n';
+
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file    minimize.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Delta debugging minimizer for inputs on which tfc fails or is slow.
+ */
+
+#if !defined(_MINIMIZE_H__20261017_1500__INCLUDED_)
+#define _MINIMIZE_H__20261017_1500__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section minimizer interface.
+ *
+ * An input is interesting if tfc, run with the given options:
+ *   FAILS   - exits with an error, is killed or times out,
+ *   DIFFERS - gives different output or status from the oracle executable,
+ *   SLOW    - takes longer than 'budget' nanoseconds per byte when the
+ *             input is tiled to 'size' bytes.
+ * The minimizer cuts whole lines first and then byte ranges, keeping the
+ * smallest input that is still interesting.
+ */
+
+struct Predicate
+{
+    enum Kind { FAILS, DIFFERS, SLOW } kind{FAILS};
+    std::string options{};
+    std::string oracle{};       // Executable to compare with for DIFFERS.
+    double budget{};            // Nanoseconds per byte for SLOW.
+    size_t size{4 << 20};       // Bytes a SLOW input is tiled to.
+    double timeout{10};         // Seconds for FAILS and DIFFERS.
+};
+
+extern bool interesting(const std::string & dir, const Predicate & predicate, const std::string & input);
+extern std::string minimize(const std::string & dir, const Predicate & predicate, const std::string & input, int jobs);
+extern std::string fixtureCode(const std::string & name, const std::string & input, const std::string & comment);
+extern int minimizeCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_MINIMIZE_H__20261017_1500__INCLUDED_)
@@ -0,0 +1,189 @@
+/**
+ * @file    noise.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmark noise control: CPU pinning, priority and frequency.
+ *
+ * pinToCpus() and setNice() only make system calls, so they are safe to
+ * call in a child between fork() and exec().
+ */
+
+#include <fstream>
+#include <sstream>
+#include <cmath>
+
+#include <sched.h>
+#include <sys/resource.h>
+
+#include "noise.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static std::string cpufreq(int cpu, const char * name)
+{
+    std::string value{};
+    if (std::ifstream is{"/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/" + name})
+        is >> value;
+
+    return value;
+}
+
+
+/**
+ * @section noise control implementation.
+ *
+ */
+
+/**
+ * @brief Parse a CPU list such as "0-3,6".
+ *
+ * @param text the CPU list.
+ * @return std::vector<int> the CPUs, empty if the list is not valid.
+ */
+std::vector<int> parseCpuList(const std::string & text)
+{
+    std::vector<int> cpus{};
+    std::istringstream is{text};
+    for (std::string range; getline(is, range, ','); )
+    {
+        try
+        {
+            size_t pos{};
+            const int first{std::stoi(range, &pos)};
+            const int last{pos < range.size() && range[pos] == '-' ? std::stoi(range.substr(pos + 1)) : first};
+            if ((first < 0) || (last < first) || (last >= CPU_SETSIZE))
+                return std::vector<int>{};
+
+            for (int cpu = first; cpu <= last; ++cpu)
+                cpus.push_back(cpu);
+        }
+        catch (...)
+        {
+            return std::vector<int>{};
+        }
+    }
+
+    return cpus;
+}
+
+/**
+ * @brief Restrict the calling process to the given CPUs.
+ *
+ * @param cpus to run on, all CPUs if empty.
+ * @return int error value or 0 if no errors.
+ */
+int pinToCpus(const std::vector<int> & cpus)
+{
+    if (cpus.empty())
+        return 0;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus)
+        CPU_SET(cpu, &set);
+
+    return sched_setaffinity(0, sizeof(set), &set) ? 1 : 0;
+}
+
+/**
+ * @brief Set the nice value of the calling process. Raising the priority
+ * (a negative value) needs CAP_SYS_NICE or a suitable RLIMIT_NICE.
+ *
+ * @param nice value, 0 to leave the priority alone.
+ * @return int error value or 0 if no errors.
+ */
+int setNice(int nice)
+{
+    if (!nice)
+        return 0;
+
+    return setpriority(PRIO_PROCESS, 0, nice) ? 1 : 0;
+}
+
+/**
+ * @brief Get the cpufreq governor of a CPU.
+ *
+ * @param cpu number.
+ * @return std::string the governor, or "unknown".
+ */
+std::string cpuGovernor(int cpu)
+{
+    const std::string governor{cpufreq(cpu, "scaling_governor")};
+
+    return governor.empty() ? "unknown" : governor;
+}
+
+/**
+ * @brief Get the current frequency of a CPU.
+ *
+ * @param cpu number.
+ * @return double the frequency in MHz, or 0 if unknown.
+ */
+double cpuFrequency(int cpu)
+{
+    const std::string khz{cpufreq(cpu, "scaling_cur_freq")};
+    if (!khz.empty())
+        return std::stod(khz) / 1000;
+
+    if (std::ifstream is{"/proc/cpuinfo"})
+    {
+        int processor{-1};
+        for (std::string line; getline(is, line); )
+        {
+            const auto colon{line.find(':')};
+            if (colon == std::string::npos)
+                continue;
+
+            if (line.compare(0, 9, "processor") == 0)
+                processor = std::stoi(line.substr(colon + 1));
+            else if ((processor == cpu) && (line.compare(0, 7, "cpu MHz") == 0))
+                return std::stod(line.substr(colon + 1));
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Get the spread of a set of measurements as the standard deviation
+ * relative to the mean, the coefficient of variation.
+ *
+ * @param values measured.
+ * @return double the relative spread, 0 for fewer than two values.
+ */
+double relativeSpread(const std::vector<double> & values)
+{
+    if (values.size() < 2)
+        return 0;
+
+    double sum{};
+    for (const auto value : values)
+        sum += value;
+    const double mean{sum / values.size()};
+    if (!mean)
+        return 0;
+
+    double squares{};
+    for (const auto value : values)
+        squares += (value - mean) * (value - mean);
+
+    return std::sqrt(squares / (values.size() - 1)) / mean;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file    noise.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Benchmark noise control: CPU pinning, priority and frequency.
+ */
+
+#if !defined(_NOISE_H__20261017_1230__INCLUDED_)
+#define _NOISE_H__20261017_1230__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section noise control interface.
+ *
+ * CPU lists use the kernel's format, e.g. "2", "2,3" or "0-3,6". The
+ * governor and frequency are read from cpufreq in sysfs, falling back to
+ * /proc/cpuinfo for the frequency where cpufreq is not available.
+ */
+
+extern std::vector<int> parseCpuList(const std::string & text);
+extern int pinToCpus(const std::vector<int> & cpus);
+extern int setNice(int nice);
+
+extern std::string cpuGovernor(int cpu);
+extern double cpuFrequency(int cpu);
+
+extern double relativeSpread(const std::vector<double> & values);
+
+
+#endif // !defined(_NOISE_H__20261017_1230__INCLUDED_)
@@ -0,0 +1,240 @@
+/**
+ * @file    pipeline.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Cost of chained single-option tfc invocations against one combined pass.
+ *
+ * The combined and chained runs are interleaved so that drift in the
+ * machine state affects both equally.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "pipeline.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// A combined run taking no more than this multiple of its slowest step is
+// judged to be a single pass.
+static const double singlePass{1.25};
+
+static const std::vector<PipelineCase> pipelineCases{
+    { "-s -d", { "-s", "-d" } },
+    { "-s -u", { "-s", "-u" } },
+    { "-t -u -4", { "-t -4", "-u" } },
+    { "-t -d -8", { "-t -8", "-d" } },
+};
+
+static double timeCommand(const std::string & command)
+{
+    Usage usage{};
+    if (spawn(command, usage))
+        return -1;
+
+    return usage.elapsed;
+}
+
+
+/**
+ * @brief Time a combined invocation against the chain of single-option
+ * invocations and check both give the same output.
+ *
+ * @return int error value or 0 if the outputs matched.
+ */
+static int runCase(const std::string & dir, const std::string & inputFileName, const std::string & profile, const PipelineCase & c, int repeat)
+{
+    const std::string combinedFileName{dir + "/pipelineCombined.txt"};
+    std::vector<std::string> stepFileNames{};
+    for (size_t i = 0; i < c.steps.size(); ++i)
+        stepFileNames.push_back(dir + "/pipelineStep" + std::to_string(i) + ".txt");
+
+    std::vector<double> combined{};
+    std::vector<double> chained{};
+    std::vector<std::vector<double>> steps(c.steps.size());
+    int err{};
+    for (int run = 0; run < repeat && !err; ++run)
+    {
+        const double combinedTime{timeCommand(tfcPath + " " + c.combined + " -i " + inputFileName + " -o " + combinedFileName)};
+        if (combinedTime < 0)
+            err = 1;
+        combined.push_back(combinedTime);
+
+        double total{};
+        std::string from{inputFileName};
+        for (size_t i = 0; i < c.steps.size() && !err; ++i)
+        {
+            const double stepTime{timeCommand(tfcPath + " " + c.steps[i] + " -i " + from + " -o " + stepFileNames[i])};
+            if (stepTime < 0)
+                err = 1;
+            steps[i].push_back(stepTime);
+            total += stepTime;
+            from = stepFileNames[i];
+        }
+        chained.push_back(total);
+    }
+
+    const bool identical{!err && sameContent(combinedFileName, stepFileNames.back())};
+    double slowest{};
+    for (const auto & step : steps)
+        slowest = std::max(slowest, median(step));
+
+    std::string chain{};
+    for (const auto & step : c.steps)
+        chain += (chain.empty() ? "" : " | ") + step;
+
+    const double combinedTime{median(combined)};
+    const double chainedTime{median(chained)};
+    std::cout << std::setw(8) << profile << std::setw(10) << c.combined << std::setw(20) << chain
+        << std::fixed << std::setprecision(4) << std::setw(10) << combinedTime << std::setw(10) << chainedTime
+        << std::setw(10) << slowest << std::setprecision(2) << std::setw(9) << (combinedTime ? chainedTime / combinedTime : 0)
+        << std::setw(13) << (combinedTime <= singlePass * slowest ? "single pass" : "multi pass")
+        << "  " << (identical ? "identical" : "DIFFERENT") << '\n';
+
+    std::filesystem::remove(combinedFileName);
+    for (const auto & fileName : stepFileNames)
+        std::filesystem::remove(fileName);
+
+    return identical ? 0 : 1;
+}
+
+
+/**
+ * @section pipeline comparison implementation.
+ *
+ */
+
+/**
+ * @brief Time each combined invocation against its chain of single-option
+ * invocations on a generated file of the given profile.
+ *
+ * @param dir working directory for the generated files.
+ * @param profile name of the generation profile.
+ * @param cases the combined options and the equivalent chains.
+ * @param size of the generated input in bytes.
+ * @param repeat number of timed runs of each.
+ * @return int the number of cases whose outputs differed or failed.
+ */
+int pipelineCompare(const std::string & dir, const std::string & profile, const std::vector<PipelineCase> & cases, size_t size, int repeat)
+{
+    const Profile * found{findProfile(profile)};
+    if (!found)
+    {
+        std::cerr << "Unknown profile " << profile << '\n';
+
+        return 1;
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/pipeline.txt"};
+    if (generateFile(inputFileName, *found, size))
+        return 1;
+
+    int differences{};
+    for (const auto & c : cases)
+        if (runCase(dir, inputFileName, profile, c, repeat))
+            ++differences;
+
+    std::filesystem::remove(inputFileName);
+
+    return differences;
+}
+
+/**
+ * @brief Command line entry point for the pipeline comparison.
+ *
+ *   test pipeline [--size S] [--repeat N] [--profile name]... [--options "combined" "step|step..."]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "pipeline".
+ * @return int error value or 0 if no errors.
+ */
+int pipelineCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t size{64 << 20};
+    int repeat{5};
+    std::vector<std::string> profiles{};
+    std::vector<PipelineCase> cases{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], repeat, 1);
+        else if (args[i] == "--profile" && value)
+            profiles.push_back(args[++i]);
+        else if (args[i] == "--options" && i + 2 < args.size())
+        {
+            PipelineCase c{args[++i], {}};
+            std::string steps{args[++i]};
+            for (size_t pos{}; pos != std::string::npos; )
+            {
+                const size_t bar{steps.find('|', pos)};
+                c.steps.push_back(steps.substr(pos, bar == std::string::npos ? bar : bar - pos));
+                pos = (bar == std::string::npos) ? bar : bar + 1;
+            }
+            cases.push_back(c);
+        }
+        else
+        {
+            std::cerr << "Unknown pipeline argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (profiles.empty())
+        profiles = { "mixed", "indent" };
+    if (cases.empty())
+        cases = pipelineCases;
+    for (const auto & c : cases)
+        if (c.steps.empty() || c.steps.back().empty())
+        {
+            std::cerr << "Invalid pipeline chain for " << c.combined << '\n';
+
+            return 1;
+        }
+
+    std::cout << "\nCombined against chained invocations on " << size << " byte files, median of " << repeat << " runs.\n";
+    std::cout << "Speed-up is chained time / combined time, single pass if combined is within "
+        << singlePass << " x the slowest step.\n";
+    std::cout << std::setw(8) << "Profile" << std::setw(10) << "Combined" << std::setw(20) << "Chain"
+        << std::setw(10) << "Combined" << std::setw(10) << "Chained" << std::setw(10) << "Slowest"
+        << std::setw(9) << "Speed-up" << std::setw(13) << "Passes" << "  Output\n";
+
+    int differences{};
+    for (const auto & profile : profiles)
+        differences += pipelineCompare(dir, profile, cases, size, repeat);
+
+    if (differences)
+        std::cout << differences << " combined invocation(s) gave output different from the chain.\n";
+
+    return differences ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+/**
+ * @file    pipeline.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Cost of chained single-option tfc invocations against one combined pass.
+ */
+
+#if !defined(_PIPELINE_H__20261017_1600__INCLUDED_)
+#define _PIPELINE_H__20261017_1600__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section pipeline comparison interface.
+ *
+ * A combined invocation such as 'tfc -s -d' is timed against running
+ * 'tfc -s' then 'tfc -d' through an intermediate file. If tfc converts in
+ * a single pass the combined run costs no more than its slowest step.
+ */
+
+struct PipelineCase
+{
+    std::string combined;               // Options of the single invocation.
+    std::vector<std::string> steps;     // Options of each chained invocation.
+};
+
+extern int pipelineCompare(const std::string & dir, const std::string & profile, const std::vector<PipelineCase> & cases, size_t size, int repeat);
+extern int pipelineCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_PIPELINE_H__20261017_1600__INCLUDED_)
@@ -0,0 +1,242 @@
+/**
+ * @file    replace.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Write amplification and atomicity analysis of tfc replace mode.
+ *
+ * inotify events name the directory entry, not the inode, so a write to
+ * the target before anything is renamed over it is a write to the
+ * original file. Identical consecutive events are merged by the kernel,
+ * so the queue does not overflow on a long run of writes.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <filesystem>
+
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "gen.h"
+#include "bench.h"
+#include "replace.h"
+
+/**
+ * @section basic utility code.
+ */
+
+// Replacing a file must not write much more than the result.
+static const double maxWrite{1.5};
+
+static ino_t inode(const std::string & fileName, size_t & size)
+{
+    struct stat info{};
+    if (stat(fileName.c_str(), &info) < 0)
+    {
+        size = 0;
+
+        return 0;
+    }
+
+    size = info.st_size;
+
+    return info.st_ino;
+}
+
+static std::set<std::string> listDirectory(const std::string & dir)
+{
+    std::set<std::string> names{};
+    for (const auto & entry : std::filesystem::directory_iterator{dir})
+        names.insert(entry.path().filename().string());
+
+    return names;
+}
+
+/**
+ * @brief Apply the queued inotify events for the directory to the report.
+ *
+ * @param fd inotify file descriptor, non-blocking.
+ * @param target name of the replaced file within the directory.
+ * @param report updated with what happened to the directory.
+ */
+static void readEvents(int fd, const std::string & target, ReplaceReport & report)
+{
+    std::vector<char> buffer(64 << 10);
+    for (;;)
+    {
+        const ssize_t length{read(fd, buffer.data(), buffer.size())};
+        if (length <= 0)
+            break;
+
+        for (ssize_t pos = 0; pos < length; )
+        {
+            const auto * event{reinterpret_cast<const inotify_event *>(buffer.data() + pos)};
+            pos += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+                report.overflow = true;
+            if (!event->len)
+                continue;
+
+            const std::string name{event->name};
+            if (name != target)
+            {
+                if (event->mask & IN_CREATE)
+                    ++report.tempFiles;
+            }
+            else if (event->mask & IN_MOVED_TO)
+                report.renamed = true;
+            else if ((event->mask & IN_MODIFY) && !report.renamed)
+                report.modified = true;
+            else if (event->mask & (IN_DELETE | IN_MOVED_FROM | IN_CREATE))
+                report.removed = true;
+        }
+    }
+}
+
+
+/**
+ * @section replace mode analysis implementation.
+ *
+ */
+
+/**
+ * @brief Run tfc in replace mode on a file and record how the file was
+ * replaced. The directory should contain nothing that changes during the
+ * run other than the file itself.
+ *
+ * @param fileName of the file to replace.
+ * @param options tfc conversion options to use.
+ * @param report of the run, populated on return.
+ * @param replace spelling of the replace option, "-r" or "--replace".
+ * @return int exit code of tfc, or -1 if the directory could not be watched.
+ */
+int analyseReplace(const std::string & fileName, const std::string & options, ReplaceReport & report, const std::string & replace)
+{
+    const std::filesystem::path path{fileName};
+    const std::string dir{path.parent_path().string()};
+    const std::string target{path.filename().string()};
+
+    report = ReplaceReport{tfcPath + " " + options + " " + replace + " " + fileName};
+    const ino_t original{inode(fileName, report.before)};
+    const auto existing{listDirectory(dir)};
+
+    const int fd{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)};
+    if (fd < 0)
+        return -1;
+    if (inotify_add_watch(fd, dir.c_str(), IN_CREATE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE) < 0)
+    {
+        close(fd);
+
+        return -1;
+    }
+
+    const int status{spawn(report.command, report.usage, Limits{0, 0, true})};
+    readEvents(fd, target, report);
+    close(fd);
+
+    report.inodeChanged = (inode(fileName, report.after) != original);
+    for (const auto & name : listDirectory(dir))
+        if ((name != target) && !existing.count(name))
+            ++report.leftovers;
+
+    if (report.after)
+        report.writeAmplification = static_cast<double>(report.usage.wchar) / report.after;
+    report.atomic = report.renamed && report.inodeChanged && !report.modified && !report.removed && !report.overflow;
+
+    return status;
+}
+
+/**
+ * @brief Replace a generated file with tfc and check that the replacement
+ * is atomic, writes the result about once, leaves no temporary files behind
+ * and matches the output of the same conversion to a separate file.
+ *
+ * @param dir working directory for the generated files.
+ * @param options tfc conversion options to use.
+ * @param size of the generated file in bytes.
+ * @param replace spelling of the replace option, "-r" or "--replace".
+ * @return int error value or 0 if no errors.
+ */
+int replaceCheck(const std::string & dir, const std::string & options, size_t size, const std::string & replace)
+{
+    const std::string replaceDir{dir + "/replace"};
+    std::filesystem::create_directories(replaceDir);
+    const std::string fileName{replaceDir + "/replace.txt"};
+    const std::string expectedFileName{dir + "/replaceExpected.txt"};
+
+    if (generateFile(fileName, *findProfile("all"), size))
+        return 1;
+
+    Usage usage{};
+    int err{spawn(tfcPath + " " + options + " -i " + fileName + " -o " + expectedFileName, usage)};
+
+    ReplaceReport report{};
+    if (analyseReplace(fileName, options, report, replace))
+        err = 1;
+
+    const bool same{sameContent(fileName, expectedFileName)};
+    std::cout << "  " << report.command << " : " << std::fixed << std::setprecision(2) << report.writeAmplification
+        << "x written (" << report.usage.wchar << " bytes, " << report.usage.writeBytes << " to disk), "
+        << report.tempFiles << " temp file(s), " << report.usage.syncs << " sync(s), "
+        << (report.atomic ? "atomic" : "NOT atomic")
+        << (report.modified ? ", original rewritten" : "") << (report.removed ? ", original removed" : "")
+        << (report.overflow ? ", events lost" : "") << (report.leftovers ? ", files left behind" : "")
+        << (same ? "" : ", content differs") << '\n';
+
+    if (!report.atomic || report.leftovers || !same || (report.writeAmplification > maxWrite))
+        err = 1;
+
+    std::filesystem::remove_all(replaceDir);
+    std::filesystem::remove(expectedFileName);
+
+    return err;
+}
+
+/**
+ * @brief Check replace mode with each conversion on a large file.
+ *
+ *   test replace [size]
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "replace".
+ * @return int error value or 0 if no errors.
+ */
+int replaceCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    const std::vector<std::string> optionSets{ "-u", "-d", "-s -u", "-t -d" };
+
+    size_t size{256 * MiB};
+    if ((args.size() > 1) && parseSize(args[1], size))
+        return 1;
+
+    std::cout << "\nReplace mode analysis of " << size << " byte files:\n";
+    int failed{};
+    for (const auto & options : optionSets)
+        if (replaceCheck(dir, options, size))
+            ++failed;
+
+    if (failed)
+        std::cout << failed << " replacement(s) were not atomic, doubled the writes or gave the wrong result.\n";
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file    replace.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Write amplification and atomicity analysis of tfc replace mode.
+ */
+
+#if !defined(_REPLACE_H__20261017_1200__INCLUDED_)
+#define _REPLACE_H__20261017_1200__INCLUDED_
+
+#include <string>
+#include <vector>
+
+#include "spawn.h"
+
+
+/**
+ * @section replace mode analysis interface.
+ *
+ * The directory holding the file is watched with inotify while tfc -r runs
+ * under ptrace. A replacement is atomic if a new inode is renamed over the
+ * file and the original inode is never written, removed or moved aside, so
+ * a reader always sees either the old or the new content in full.
+ */
+
+struct ReplaceReport
+{
+    std::string command;
+    size_t before{};            // File size before the run.
+    size_t after{};             // File size after the run.
+    Usage usage{};
+    double writeAmplification{};    // Bytes written per byte of result.
+    int tempFiles{};            // Other files created in the directory.
+    int leftovers{};            // Other files still present afterwards.
+    bool renamed{};             // A file was renamed over the target.
+    bool modified{};            // The original inode was written to.
+    bool removed{};             // The target was deleted or moved aside.
+    bool inodeChanged{};
+    bool overflow{};            // inotify events were lost.
+    bool atomic{};
+};
+
+extern int analyseReplace(const std::string & fileName, const std::string & options, ReplaceReport & report, const std::string & replace = "-r");
+extern int replaceCheck(const std::string & dir, const std::string & options, size_t size, const std::string & replace = "-r");
+extern int replaceCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_REPLACE_H__20261017_1200__INCLUDED_)
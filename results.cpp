@@ -0,0 +1,300 @@
+/**
+ * @file    results.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Per-test timing collection and JUnit XML/JSON result export.
+ *
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "bench.h"
+#include "results.h"
+#include "trace.h"
+
+/**
+ * @section basic utility code.
+ */
+
+struct PhaseTotal
+{
+    size_t calls{};
+    double seconds{};
+    size_t bytes{};
+};
+
+struct TestTiming
+{
+    std::string name;
+    bool passed{};
+    double total{};
+    PhaseTotal phase[PHASES]{};
+};
+
+static const char * phaseNames[PHASES]{ "generate", "setup", "execute", "read", "compare" };
+
+static std::vector<TestTiming> timings{};
+static PhaseTotal totals[PHASES]{};
+static bool active{};
+static int previousErrors{};
+static Stopwatch testClock{};
+static double traceStart{};
+static std::mutex phaseMutex{};
+static thread_local bool suppressed{};
+
+static double totalTime(void)
+{
+    double total{};
+    for (const auto & timing : timings)
+        total += timing.total;
+
+    return total;
+}
+
+static int failures(void)
+{
+    int count{};
+    for (const auto & timing : timings)
+        if (!timing.passed)
+            ++count;
+
+    return count;
+}
+
+/**
+ * @brief Escape a string for use in an XML attribute or JSON string.
+ */
+static std::string escape(const std::string & text, bool xml)
+{
+    std::string escaped{};
+    for (const auto c : text)
+    {
+        if (xml && c == '&')
+            escaped += "&amp;";
+        else if (xml && c == '<')
+            escaped += "&lt;";
+        else if (xml && c == '"')
+            escaped += "&quot;";
+        else if (!xml && (c == '"' || c == '\\'))
+            escaped += std::string{'\\', c};
+        else
+            escaped += c;
+    }
+
+    return escaped;
+}
+
+
+/**
+ * @section per-test timing implementation.
+ *
+ */
+
+/**
+ * @brief Start timing the named test.
+ *
+ * @param name of the test.
+ */
+void startTest(const std::string & name)
+{
+    timings.push_back(TestTiming{name});
+    testClock = Stopwatch{};
+    traceStart = traceClock();
+    active = true;
+}
+
+/**
+ * @brief Stop timing the current test.
+ *
+ * @param errors the total error count so far, the test failed if it has
+ * increased since the previous test.
+ */
+void stopTest(int errors)
+{
+    if (!active)
+        return;
+
+    auto & timing{timings.back()};
+    timing.total = testClock.elapsed();
+
+    double setup{timing.total};
+    for (int phase = 0; phase < PHASES; ++phase)
+        if (phase != SETUP)
+            setup -= timing.phase[phase].seconds;
+    setup = std::max(setup, 0.0);
+    timing.phase[SETUP] = PhaseTotal{1, setup};
+    totals[SETUP].calls++;
+    totals[SETUP].seconds += setup;
+
+    timing.passed = (errors == previousErrors);
+    previousErrors = errors;
+    active = false;
+    traceEvent(timing.name, "test", traceStart, { { "passed", timing.passed ? "true" : "false" } });
+}
+
+/**
+ * @brief Add time spent and bytes moved in a phase to the harness totals
+ * and to the current test, if a test is being timed. May be called from
+ * worker threads.
+ *
+ * @param phase the time was spent in.
+ * @param seconds spent.
+ * @param bytes moved.
+ */
+void recordPhase(Phase phase, double seconds, size_t bytes)
+{
+    if (suppressed)
+        return;
+
+    auto add = [=](PhaseTotal & total) { total.calls++; total.seconds += seconds; total.bytes += bytes; };
+
+    std::lock_guard<std::mutex> lock{phaseMutex};
+    add(totals[phase]);
+    if (active)
+        add(timings.back().phase[phase]);
+}
+
+/**
+ * @brief Stop recording phases from the calling thread, for worker threads
+ * whose phases overlap. Their caller records the wall clock span instead,
+ * so the phases of a test never add up to more than its total.
+ */
+void suppressPhases(void)
+{
+    suppressed = true;
+}
+
+/**
+ * @brief Output the time and bytes moved in each phase across the whole
+ * run, optionally followed by the breakdown for each test.
+ *
+ * @param detail output the per-test breakdown if true.
+ */
+void outputPhases(bool detail)
+{
+    double total{};
+    for (const auto & phase : totals)
+        total += phase.seconds;
+
+    std::cout << "\nHarness phase breakdown:\n";
+    std::cout << std::setw(10) << "Phase" << std::setw(8) << "Calls" << std::setw(11) << "Seconds" << std::setw(9) << "Percent"
+        << std::setw(14) << "Bytes" << std::setw(10) << "MiB/s" << '\n';
+    std::cout << std::fixed;
+    for (int phase = 0; phase < PHASES; ++phase)
+    {
+        const auto & t{totals[phase]};
+        std::cout << std::setw(10) << phaseNames[phase] << std::setw(8) << t.calls
+            << std::setw(11) << std::setprecision(4) << t.seconds
+            << std::setw(8) << std::setprecision(1) << (total ? 100 * t.seconds / total : 0) << '%'
+            << std::setw(14) << t.bytes
+            << std::setw(10) << (t.seconds ? t.bytes / static_cast<double>(MiB) / t.seconds : 0) << '\n';
+    }
+
+    if (!detail)
+        return;
+
+    std::cout << "\nPer-test phase breakdown (seconds, bytes):\n";
+    std::cout << std::setw(14) << "Test";
+    for (int phase = 0; phase < PHASES; ++phase)
+        std::cout << std::setw(22) << phaseNames[phase];
+    std::cout << '\n';
+    for (const auto & timing : timings)
+    {
+        std::cout << std::setw(14) << timing.name << std::setprecision(4);
+        for (const auto & t : timing.phase)
+            std::cout << std::setw(10) << t.seconds << std::setw(12) << t.bytes;
+        std::cout << '\n';
+    }
+}
+
+
+/**
+ * @section result export.
+ *
+ */
+
+/**
+ * @brief Write the test timings as a JUnit XML test suite, with the phase
+ * timings of each test case recorded as properties.
+ *
+ * @param fileName of the XML file to write.
+ * @return int error value or 0 if no errors.
+ */
+int writeJUnit(const std::string & fileName)
+{
+    if (std::ofstream os{fileName, std::ios::out})
+    {
+        os << std::fixed << std::setprecision(6);
+        os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        os << "<testsuite name=\"tfcTest\" tests=\"" << timings.size() << "\" failures=\"" << failures()
+            << "\" time=\"" << totalTime() << "\">\n";
+        for (const auto & timing : timings)
+        {
+            os << "  <testcase classname=\"tfcTest\" name=\"" << escape(timing.name, true) << "\" time=\"" << timing.total << "\">\n";
+            os << "    <properties>\n";
+            for (int phase = 0; phase < PHASES; ++phase)
+                os << "      <property name=\"" << phaseNames[phase] << "\" value=\"" << timing.phase[phase].seconds << "\"/>\n";
+            os << "    </properties>\n";
+            if (!timing.passed)
+                os << "    <failure message=\"" << escape(timing.name, true) << " failed\"/>\n";
+            os << "  </testcase>\n";
+        }
+        os << "</testsuite>\n";
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Write the test timings as JSON.
+ *
+ * @param fileName of the JSON file to write.
+ * @return int error value or 0 if no errors.
+ */
+int writeJson(const std::string & fileName)
+{
+    if (std::ofstream os{fileName, std::ios::out})
+    {
+        os << std::fixed << std::setprecision(6);
+        os << "{\n  \"suite\": \"tfcTest\",\n  \"tests\": " << timings.size() << ",\n  \"failures\": " << failures()
+            << ",\n  \"time\": " << totalTime() << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < timings.size(); ++i)
+        {
+            const auto & timing{timings[i]};
+            os << "    { \"name\": \"" << escape(timing.name, false) << "\", \"passed\": " << (timing.passed ? "true" : "false")
+                << ", \"time\": " << timing.total;
+            for (int phase = 0; phase < PHASES; ++phase)
+                os << ", \"" << phaseNames[phase] << "\": " << timing.phase[phase].seconds
+                    << ", \"" << phaseNames[phase] << "Bytes\": " << timing.phase[phase].bytes;
+            os << " }" << (i + 1 < timings.size() ? "," : "") << '\n';
+        }
+        os << "  ]\n}\n";
+
+        return 0;
+    }
+
+    return 1;
+}
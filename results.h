@@ -0,0 +1,66 @@
+/**
+ * @file    results.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Per-test timing collection and JUnit XML/JSON result export.
+ */
+
+#if !defined(_RESULTS_H__20261017_1000__INCLUDED_)
+#define _RESULTS_H__20261017_1000__INCLUDED_
+
+#include <string>
+#include <chrono>
+
+
+/**
+ * @section per-test timing interface.
+ *
+ * Phases are fixture generation, spawning tfc, reading files back and
+ * comparing them. Time within a test not spent in another phase is
+ * attributed to setup. Phases recorded outside of any test, such as the
+ * fixture generation in init(), count towards the harness totals only.
+ * Threads running phases concurrently suppress their own records, and the
+ * caller records one wall clock span for them instead.
+ */
+
+enum Phase { GENERATE, SETUP, EXECUTE, READ, COMPARE, PHASES };
+
+class Stopwatch
+{
+public:
+    Stopwatch(void) : start{std::chrono::steady_clock::now()} {}
+
+    double elapsed(void) const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+private:
+    std::chrono::steady_clock::time_point start;
+
+};
+
+extern void startTest(const std::string & name);
+extern void stopTest(int errors);
+extern void recordPhase(Phase phase, double seconds, size_t bytes = 0);
+extern void suppressPhases(void);
+
+extern void outputPhases(bool detail);
+extern int writeJUnit(const std::string & fileName);
+extern int writeJson(const std::string & fileName);
+
+
+#endif // !defined(_RESULTS_H__20261017_1000__INCLUDED_)
@@ -0,0 +1,377 @@
+/**
+ * @file    spawn.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Child process execution with resource limits and usage accounting.
+ *
+ * Commands are run as "sh -c 'exec command'" so the shell is replaced by
+ * the command and the pid, limits and usage all belong to it.
+ *
+ * When sync calls are counted the child is run under ptrace, which stops it
+ * at every system call, so elapsed times from such runs are not comparable
+ * with untraced runs.
+ *
+ * When instructions are counted the child waits on a pipe until the
+ * counter has been attached, and counting starts at its first exec. The
+ * count includes the few instructions of the shell before it execs the
+ * command. Virtual machines often have no hardware counters, in which
+ * case the count is left at -1.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/uio.h>
+#include <elf.h>
+#include <linux/perf_event.h>
+
+#include "spawn.h"
+#include "results.h"
+#include "trace.h"
+#include "accounting.h"
+#include "noise.h"
+
+
+/**
+ * @section basic utility code.
+ */
+
+std::string tfcPath{"tfc"};
+
+static double toSeconds(const timeval & tv)
+{
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * @brief Wait for the child to exit, killing it if the timeout expires.
+ *
+ * Uses a pidfd so that the wait can be bounded without polling, falls back
+ * to an unbounded wait if pidfds are not supported. Either way the child is
+ * left unreaped so that its /proc entry can still be read.
+ *
+ * @param pid of the child process.
+ * @param timeout in seconds, 0 for no limit.
+ * @return true if the child was killed because the timeout expired.
+ */
+static bool awaitExit(pid_t pid, double timeout)
+{
+    const int fd = syscall(SYS_pidfd_open, pid, 0);
+    if (fd < 0)
+    {
+        siginfo_t info{};
+        while ((waitid(P_PID, pid, &info, WEXITED|WNOWAIT) < 0) && (errno == EINTR))
+            ;
+
+        return false;
+    }
+
+    pollfd event{fd, POLLIN, 0};
+    const int ms{timeout > 0 ? static_cast<int>(timeout * 1000) : -1};
+
+    int ready;
+    do
+        ready = poll(&event, 1, ms);
+    while ((ready < 0) && (errno == EINTR));
+
+    close(fd);
+    if (ready == 0)
+    {
+        kill(pid, SIGKILL);
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Read the I/O accounting of an exited but not yet reaped child.
+ *
+ * @param pid of the child process.
+ * @param usage updated with the I/O counters.
+ */
+static void readIo(pid_t pid, Usage & usage)
+{
+    if (std::ifstream is{"/proc/" + std::to_string(pid) + "/io"})
+    {
+        std::string name;
+        size_t value;
+        while (is >> name >> value)
+        {
+            if (name == "rchar:")
+                usage.rchar = value;
+            else if (name == "wchar:")
+                usage.wchar = value;
+            else if (name == "syscr:")
+                usage.syscr = value;
+            else if (name == "syscw:")
+                usage.syscw = value;
+            else if (name == "read_bytes:")
+                usage.readBytes = value;
+            else if (name == "write_bytes:")
+                usage.writeBytes = value;
+        }
+    }
+}
+
+
+/**
+ * @brief Get the number of the system call a stopped tracee is making.
+ *
+ * @param pid of the tracee.
+ * @return long system call number, or -1 if unknown on this architecture.
+ */
+static long syscallNumber(pid_t pid)
+{
+#if defined(__x86_64__)
+    return ptrace(PTRACE_PEEKUSER, pid, offsetof(user_regs_struct, orig_rax), nullptr);
+#elif defined(__aarch64__)
+    user_regs_struct regs{};
+    iovec io{&regs, sizeof(regs)};
+    if (ptrace(PTRACE_GETREGSET, pid, NT_PRSTATUS, &io) < 0)
+        return -1;
+
+    return regs.regs[8];
+#else
+    return -1;
+#endif
+}
+
+static bool isSync(long number)
+{
+    return number == SYS_fsync || number == SYS_fdatasync || number == SYS_sync ||
+        number == SYS_syncfs || number == SYS_sync_file_range;
+}
+
+/**
+ * @brief Follow a child that called PTRACE_TRACEME through to its exit,
+ * counting the calls it makes that flush data to storage.
+ *
+ * The I/O counters are read at the exit stop, before the child is reaped.
+ * The timeout is checked at each stop, so a child that spins without
+ * making system calls is not interrupted.
+ *
+ * @param pid of the child process.
+ * @param timeout in seconds, 0 for no limit.
+ * @param usage updated with the sync count and I/O counters.
+ * @param status of the reaped child.
+ * @param ru resource usage of the reaped child.
+ * @return true if the child was killed because the timeout expired.
+ */
+static bool traceSyncs(pid_t pid, double timeout, Usage & usage, int & status, rusage & ru)
+{
+    using namespace std::chrono;
+
+    const auto deadline{steady_clock::now() + duration<double>(timeout)};
+    bool timedOut{};
+
+    // The first stop is the SIGTRAP delivered on the exec of the shell.
+    while ((wait4(pid, &status, __WALL, &ru) < 0) && (errno == EINTR))
+        ;
+    if (!WIFSTOPPED(status))
+        return false;
+
+    ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+        PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACEEXEC | PTRACE_O_TRACEEXIT | PTRACE_O_EXITKILL);
+
+    int signal{};
+    bool entry{};
+    for (;;)
+    {
+        ptrace(PTRACE_SYSCALL, pid, nullptr, signal);
+        signal = 0;
+        while ((wait4(pid, &status, __WALL, &ru) < 0) && (errno == EINTR))
+            ;
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            break;
+
+        const int stop{WSTOPSIG(status)};
+        if (stop == (SIGTRAP | 0x80))
+        {
+            entry = !entry;
+            if (entry && isSync(syscallNumber(pid)))
+                ++usage.syncs;
+        }
+        else if ((stop == SIGTRAP) && ((status >> 16) == PTRACE_EVENT_EXIT))
+            readIo(pid, usage);
+        else if (stop != SIGTRAP)
+            signal = stop;
+
+        if ((timeout > 0) && !timedOut && (steady_clock::now() > deadline))
+        {
+            kill(pid, SIGKILL);
+            timedOut = true;
+        }
+    }
+
+    return timedOut;
+}
+
+
+/**
+ * @brief Attach a user space instruction counter to a child that has not
+ * yet called exec().
+ *
+ * @param pid of the child process.
+ * @return int the counter file descriptor, or -1 if not available.
+ */
+static int openInstructionCounter(pid_t pid)
+{
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+/**
+ * @section child process execution implementation.
+ *
+ */
+
+/**
+ * @brief Run a command as a child process and collect its resource usage.
+ *
+ * @param command line to execute.
+ * @param usage of the child process, populated on return.
+ * @param limits to apply to the child process.
+ * @return int exit code of the command, 128 + signal if it was killed, or
+ * -1 if the child could not be created.
+ */
+int spawn(const std::string & command, Usage & usage, const Limits & limits)
+{
+    using namespace std::chrono;
+
+    usage = Usage{};
+    const std::string line{"exec " + command};  // Build before fork().
+    const double traceStart{traceClock()};
+    const auto start{steady_clock::now()};
+
+    int gate[2]{-1, -1};
+    if (limits.countInstructions && pipe2(gate, O_CLOEXEC))
+        return -1;
+
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        if (gate[0] >= 0)
+        {
+            close(gate[0]);
+            close(gate[1]);
+        }
+
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        if (gate[0] >= 0)
+        {
+            char go;
+            close(gate[1]);
+            while ((read(gate[0], &go, 1) < 0) && (errno == EINTR))
+                ;
+        }
+        if (limits.memory)
+        {
+            const rlimit limit{limits.memory, limits.memory};
+            setrlimit(RLIMIT_AS, &limit);
+            setrlimit(RLIMIT_DATA, &limit);
+        }
+        pinToCpus(limits.cpus);
+        setNice(limits.nice);
+        if (limits.countSyncs)
+            ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+
+        execl("/bin/sh", "sh", "-c", line.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+
+    int counter{-1};
+    if (gate[0] >= 0)
+    {
+        close(gate[0]);
+        counter = openInstructionCounter(pid);
+        while ((write(gate[1], "", 1) < 0) && (errno == EINTR))
+            ;
+        close(gate[1]);
+    }
+
+    usage.pid = pid;
+    int status{};
+    rusage ru{};
+    if (limits.countSyncs)
+    {
+        usage.syncs = 0;
+        usage.timedOut = traceSyncs(pid, limits.timeout, usage, status, ru);
+    }
+    else
+    {
+        usage.timedOut = awaitExit(pid, limits.timeout);
+        readIo(pid, usage);
+
+        while ((wait4(pid, &status, 0, &ru) < 0) && (errno == EINTR))
+            ;
+    }
+
+    usage.elapsed = duration<double>(steady_clock::now() - start).count();
+    if (counter >= 0)
+    {
+        long long instructions{};
+        if (read(counter, &instructions, sizeof(instructions)) == sizeof(instructions))
+            usage.instructions = instructions;
+        close(counter);
+    }
+    usage.status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    usage.user = toSeconds(ru.ru_utime);
+    usage.system = toSeconds(ru.ru_stime);
+    usage.maxRss = ru.ru_maxrss;
+    usage.minorFaults = ru.ru_minflt;
+    usage.majorFaults = ru.ru_majflt;
+    usage.voluntary = ru.ru_nvcsw;
+    usage.involuntary = ru.ru_nivcsw;
+    recordPhase(EXECUTE, usage.elapsed, usage.rchar + usage.wchar);
+    recordIo(command, usage);
+    if (tracing())
+        traceEvent(command.substr(0, command.find(' ')), "execute", traceStart, {
+            { "pid", std::to_string(pid) },
+            { "argv", command },
+            { "status", std::to_string(usage.status) },
+            { "maxRss", std::to_string(usage.maxRss) } });
+
+    return usage.status;
+}
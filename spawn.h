@@ -0,0 +1,78 @@
+/**
+ * @file    spawn.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Child process execution with resource limits and usage accounting.
+ */
+
+#if !defined(_SPAWN_H__20261017_0915__INCLUDED_)
+#define _SPAWN_H__20261017_0915__INCLUDED_
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+
+/**
+ * @section child process execution interface.
+ *
+ * tfcPath is the tfc executable that every check runs, "tfc" to find it on
+ * the PATH.
+ */
+
+struct Limits
+{
+    size_t memory{};        // RLIMIT_AS and RLIMIT_DATA in bytes, 0 for unlimited.
+    double timeout{};       // Seconds before the child is killed, 0 for no limit.
+    bool countSyncs{};      // Trace the child to count fsync() and friends.
+    std::vector<int> cpus{};    // CPUs to pin the child to, empty for all.
+    int nice{};             // Nice value of the child, 0 to inherit.
+    bool countInstructions{};   // Count user space instructions with perf.
+};
+
+struct Usage
+{
+    pid_t pid{};
+    int status{};           // Exit code, or 128 + signal number if killed.
+    bool timedOut{};
+    double elapsed{};       // Wall clock seconds.
+    double user{};          // User CPU seconds.
+    double system{};        // System CPU seconds.
+    long maxRss{};          // Peak resident set size in KiB.
+    long minorFaults{};
+    long majorFaults{};
+    long voluntary{};       // Voluntary context switches.
+    long involuntary{};     // Involuntary context switches.
+    size_t rchar{};         // Bytes read, from /proc/<pid>/io.
+    size_t wchar{};         // Bytes written.
+    size_t syscr{};         // Read system calls.
+    size_t syscw{};         // Write system calls.
+    size_t readBytes{};     // Bytes fetched from storage.
+    size_t writeBytes{};    // Bytes sent to storage.
+    long syncs{-1};         // fsync(), fdatasync(), sync() etc. calls, -1 if not counted.
+    long long instructions{-1}; // User space instructions retired, -1 if not counted.
+};
+
+extern std::string tfcPath;
+
+extern int spawn(const std::string & command, Usage & usage, const Limits & limits = Limits{});
+
+
+#endif // !defined(_SPAWN_H__20261017_0915__INCLUDED_)
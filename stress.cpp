@@ -0,0 +1,167 @@
+/**
+ * @file    stress.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Pathological input stress runs of tfc.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <filesystem>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "stress.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const std::vector<std::string> stressOptions{ "-x", "-s -d", "-t -u" };
+
+// Runs slower than this are killed, after allowing for start up.
+static const double minThroughput{4 * MiB};
+static const double startupAllowance{2};
+
+static const size_t stressMemory{256 * MiB};
+
+
+/**
+ * @section stress run implementation.
+ *
+ */
+
+/**
+ * @brief Generate a file of the named shape and run tfc on it with limits
+ * on its run time and memory.
+ *
+ * @param dir working directory for the generated files.
+ * @param shape name of the pathological shape.
+ * @param options tfc options to use.
+ * @param size of the generated input in bytes.
+ * @return int error value or 0 if tfc finished within the limits.
+ */
+int stressShape(const std::string & dir, const std::string & shape, const std::string & options, size_t size)
+{
+    const Shape * found{findShape(shape)};
+    if (!found)
+    {
+        std::cerr << "Unknown shape " << shape << '\n';
+
+        return 1;
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/stress.txt"};
+    const std::string outputFileName{dir + "/stressOut.txt"};
+    if (generateShape(inputFileName, *found, size))
+        return 1;
+
+    const size_t bytes{std::filesystem::file_size(inputFileName)};
+    const Limits limits{stressMemory, startupAllowance + bytes / minThroughput};
+    Usage usage{};
+    const std::string command{tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName};
+    const int status{spawn(command, usage, limits)};
+    const bool failed{usage.timedOut || (status >= 128)};
+
+    std::cout << std::setw(10) << shape << std::setw(8) << options << std::fixed << std::setprecision(3)
+        << std::setw(10) << usage.elapsed << std::setw(10) << std::setprecision(1) << (usage.elapsed ? bytes / static_cast<double>(MiB) / usage.elapsed : 0)
+        << std::setw(12) << usage.maxRss << std::setw(8) << status
+        << (usage.timedOut ? "  <- timed out" : status >= 128 ? "  <- killed" : status ? "  (rejected)" : "") << '\n';
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+
+    return failed ? 1 : 0;
+}
+
+/**
+ * @brief Run tfc with the given options on every pathological shape.
+ *
+ * @param dir working directory for the generated files.
+ * @param options tfc options to use.
+ * @param size of each generated input in bytes.
+ * @return int the number of shapes that failed.
+ */
+int stressCheck(const std::string & dir, const std::string & options, size_t size)
+{
+    int failed{};
+    for (const auto & shape : shapeNames())
+        if (stressShape(dir, shape, options, size))
+            ++failed;
+
+    return failed;
+}
+
+/**
+ * @brief Command line entry point for the stress runs.
+ *
+ *   test stress [size] [--shape name]... [--options "opts"]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "stress".
+ * @return int error value or 0 if no errors.
+ */
+int stressCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t size{256 * MiB};
+    std::vector<std::string> shapes{};
+    std::vector<std::string> optionSets{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--shape" && value)
+            shapes.push_back(args[++i]);
+        else if (args[i] == "--options" && value)
+            optionSets.push_back(args[++i]);
+        else
+            invalid |= parseSize(args[i], size);
+    }
+    if (invalid)
+        return 1;
+    if (shapes.empty())
+        shapes = shapeNames();
+    if (optionSets.empty())
+        optionSets = stressOptions;
+
+    std::cout << "\nStress runs on " << size << " byte files, limited to " << (stressMemory / MiB) << " MiB and "
+        << (minThroughput / MiB) << " MiB/s.\n";
+    for (const auto & shape : shapes)
+    {
+        const Shape * found{findShape(shape)};
+        if (found)
+            std::cout << "  " << shape << ": " << found->description << '\n';
+    }
+    std::cout << std::setw(10) << "Shape" << std::setw(8) << "Options" << std::setw(10) << "Seconds"
+        << std::setw(10) << "MiB/s" << std::setw(12) << "RSS KiB" << std::setw(8) << "Status" << '\n';
+
+    int failed{};
+    for (const auto & shape : shapes)
+        for (const auto & options : optionSets)
+            if (stressShape(dir, shape, options, size))
+                ++failed;
+
+    if (failed)
+        std::cout << failed << " run(s) timed out or were killed.\n";
+
+    return failed ? 1 : 0;
+}
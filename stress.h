@@ -0,0 +1,45 @@
+/**
+ * @file    stress.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Pathological input stress runs of tfc.
+ */
+
+#if !defined(_STRESS_H__20261017_1400__INCLUDED_)
+#define _STRESS_H__20261017_1400__INCLUDED_
+
+#include <string>
+#include <vector>
+
+
+/**
+ * @section stress run interface.
+ *
+ * Each pathological shape from gen.h is run through tfc under a memory
+ * limit and a time limit that allows for a minimum throughput. A run
+ * fails if it is killed by the time limit or by a signal; tfc is free to
+ * reject an input with an error exit.
+ */
+
+extern int stressShape(const std::string & dir, const std::string & shape, const std::string & options, size_t size);
+extern int stressCheck(const std::string & dir, const std::string & options, size_t size);
+extern int stressCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_STRESS_H__20261017_1400__INCLUDED_)
@@ -0,0 +1,685 @@
+/**
+ * @file    summary.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * In-harness line counting and summary kernels, and the '-x' throughput
+ * benchmark built on them.
+ *
+ * The kernels use SSE2 where available, comparing 16 bytes at a time and
+ * turning the result into a bit mask, and plain loops elsewhere.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "results.h"
+#include "summary.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const size_t blockSize{1 << 20};
+
+static const std::vector<std::string> summaryProfiles{ "unix", "all", "indent", "long" };
+
+struct Field
+{
+    const char * label;
+    unsigned long long Summary::* count;
+};
+
+// In the order of the compact summary.
+static const Field fields[]{
+    { "Total Lines", &Summary::lines },
+    { "Space only", &Summary::space },
+    { "Tab only", &Summary::tab },
+    { "Neither", &Summary::neither },
+    { "Both", &Summary::both },
+    { "Dos", &Summary::dos },
+    { "Unix", &Summary::unix },
+    { "Malformed", &Summary::malformed },
+};
+
+static std::string trim(const std::string & text)
+{
+    const size_t first{text.find_first_not_of(" \t\r")};
+    if (first == std::string::npos)
+        return std::string{};
+
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+}
+
+static std::string readFile(const std::string & fileName)
+{
+    std::ifstream is{fileName, std::ios::binary};
+    std::ostringstream os{};
+    os << is.rdbuf();
+
+    return os.str();
+}
+
+/**
+ * @brief Find the next CR or LF.
+ *
+ * @return size_t the index of the first CR or LF at or after 'i', or
+ * 'length' if there is none.
+ */
+size_t findEol(const char * data, size_t i, size_t length)
+{
+#if defined(__SSE2__)
+    const __m128i lf{_mm_set1_epi8('\n')};
+    const __m128i cr{_mm_set1_epi8('\r')};
+    for (; i + 16 <= length; i += 16)
+    {
+        const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))};
+        const int mask{_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, lf), _mm_cmpeq_epi8(bytes, cr)))};
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    for (; i < length; ++i)
+        if (data[i] == '\n' || data[i] == '\r')
+            return i;
+
+    return length;
+}
+
+/**
+ * @brief Read a file a block at a time, passing each block to 'process'.
+ *
+ * @return int error value or 0 if no errors.
+ */
+template<typename T>
+static int readBlocks(const std::string & fileName, T process)
+{
+    std::ifstream is{fileName, std::ios::binary};
+    if (!is)
+        return 1;
+
+    std::vector<char> buffer(blockSize);
+    while (is)
+    {
+        is.read(buffer.data(), buffer.size());
+        process(buffer.data(), static_cast<size_t>(is.gcount()));
+    }
+
+    return is.bad() ? 1 : 0;
+}
+
+
+/**
+ * @section summary kernel implementation.
+ *
+ */
+
+bool Summary::operator==(const Summary & other) const
+{
+    return lines == other.lines && space == other.space && tab == other.tab && neither == other.neither &&
+        both == other.both && dos == other.dos && unix == other.unix && malformed == other.malformed;
+}
+
+/**
+ * @brief Scale every count, giving the summary of a file repeated 'factor'
+ * times.
+ */
+Summary Summary::operator*(unsigned long long factor) const
+{
+    Summary scaled{*this};
+    for (const auto & field : fields)
+        scaled.*field.count *= factor;
+
+    return scaled;
+}
+
+/**
+ * @brief Get the counts in the order of the second line of a compact
+ * summary.
+ *
+ * @return std::string the counts separated by spaces.
+ */
+std::string Summary::counts(void) const
+{
+    std::ostringstream os{};
+    os << lines << ' ' << space << ' ' << tab << ' ' << neither << ' ' << both << ' ' << dos << ' ' << unix << ' ' << malformed;
+
+    return os.str();
+}
+
+void SummaryCounter::endLine(Eol eol)
+{
+    ++summary.lines;
+    if (space && tab)
+        ++summary.both;
+    else if (space)
+        ++summary.space;
+    else if (tab)
+        ++summary.tab;
+    else
+        ++summary.neither;
+
+    if (eol == DOS)
+        ++summary.dos;
+    else if (eol == UNIX)
+        ++summary.unix;
+    else if (eol == MALFORMED)
+        ++summary.malformed;
+
+    leading = true;
+    inLine = space = tab = false;
+}
+
+/**
+ * @brief Count the lines in the next block of the stream.
+ *
+ * @param data of the block.
+ * @param length of the block in bytes.
+ */
+void SummaryCounter::add(const char * data, size_t length)
+{
+    size_t i{};
+    if (pending && length)
+    {
+        const char c{data[0]};
+        if (pending == '\r')
+            endLine(c == '\n' ? DOS : MALFORMED);
+        else
+            endLine(c == '\r' ? MALFORMED : UNIX);
+        if ((c == '\n' || c == '\r') && c != pending)
+            ++i;
+        pending = 0;
+    }
+
+    while (i < length)
+    {
+        for (; leading && i < length && (data[i] == ' ' || data[i] == '\t'); ++i)
+        {
+            (data[i] == ' ' ? space : tab) = true;
+            inLine = true;
+        }
+        if (i == length)
+            break;
+
+        leading = false;
+        inLine = true;
+        i = findEol(data, i, length);
+        if (i == length)
+            break;
+
+        const char c{data[i]};
+        if (++i == length)
+        {
+            pending = c;
+            break;
+        }
+
+        if (c == '\r')
+        {
+            endLine(data[i] == '\n' ? DOS : MALFORMED);
+            if (data[i] == '\n')
+                ++i;
+        }
+        else
+        {
+            endLine(data[i] == '\r' ? MALFORMED : UNIX);
+            if (data[i] == '\r')
+                ++i;
+        }
+    }
+}
+
+/**
+ * @brief Count the last line of the stream.
+ *
+ * @return const Summary& the counts for the whole stream.
+ */
+const Summary & SummaryCounter::finish(void)
+{
+    if (pending)
+        endLine(pending == '\r' ? MALFORMED : UNIX);
+    else if (inLine)
+        endLine(NO_EOL);
+    pending = 0;
+
+    return summary;
+}
+
+/**
+ * @brief Parse a tfc summary report in either the compact or the labelled
+ * form.
+ *
+ * @param text of the report.
+ * @param path set to the path of the summarised file.
+ * @param summary set to the counts.
+ * @return int error value or 0 if every count was found.
+ */
+int parseSummary(const std::string & text, std::string & path, Summary & summary)
+{
+    std::istringstream is{text};
+    if (!std::getline(is, path))
+        return 1;
+    path = trim(path);
+
+    summary = Summary{};
+    size_t found{};
+    for (std::string line; std::getline(is, line); )
+    {
+        const size_t colon{line.find(':')};
+        if (colon == std::string::npos)
+        {
+            std::istringstream values{line};
+            for (const auto & field : fields)
+                if (values >> summary.*field.count)
+                    ++found;
+
+            continue;
+        }
+
+        const std::string label{trim(line.substr(0, colon))};
+        for (const auto & field : fields)
+            if (label == field.label)
+            {
+                std::istringstream value{line.substr(colon + 1)};
+                if (value >> summary.*field.count)
+                    ++found;
+            }
+    }
+
+    return found == std::size(fields) ? 0 : 1;
+}
+
+/**
+ * @brief Describe the counts that differ between two summaries.
+ *
+ * @param actual counts.
+ * @param expected counts.
+ * @return std::string each differing count, empty if the summaries match.
+ */
+std::string summaryDifferences(const Summary & actual, const Summary & expected)
+{
+    std::ostringstream os{};
+    for (const auto & field : fields)
+        if (actual.*field.count != expected.*field.count)
+            os << (os.tellp() ? ", " : "") << field.label << ' ' << actual.*field.count << " expected " << expected.*field.count;
+
+    return os.str();
+}
+
+/**
+ * @brief Check a tfc summary report against the counts from the in-harness
+ * kernel, field by field.
+ *
+ * @param inputFileName of the summarised file.
+ * @param summaryFileName of the tfc report.
+ * @return int error value or 0 if the report matched.
+ */
+int verifySummary(const std::string & inputFileName, const std::string & summaryFileName)
+{
+    Summary expected{};
+    if (summariseFile(inputFileName, expected))
+        return 1;
+
+    return verifySummary(inputFileName, summaryFileName, expected);
+}
+
+/**
+ * @brief Check a tfc summary report against known counts, field by field.
+ *
+ * @param inputFileName of the summarised file.
+ * @param summaryFileName of the tfc report.
+ * @param expected counts for the file.
+ * @return int error value or 0 if the report matched.
+ */
+int verifySummary(const std::string & inputFileName, const std::string & summaryFileName, const Summary & expected)
+{
+    std::string path{};
+    Summary actual{};
+    if (parseSummary(readFile(summaryFileName), path, actual))
+    {
+        std::cerr << "Unable to parse summary " << summaryFileName << '\n';
+
+        return 1;
+    }
+
+    int err{};
+    if (path != inputFileName)
+    {
+        std::cerr << "Summary of " << path << " expected " << inputFileName << '\n';
+        err = 1;
+    }
+
+    const std::string differences{summaryDifferences(actual, expected)};
+    if (!differences.empty())
+    {
+        std::cerr << "Summary of " << inputFileName << ": " << differences << '\n';
+        err = 1;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Get the counts for the stream so far, as if it ended here, while
+ * leaving the counter ready for more blocks.
+ *
+ * @return Summary the counts for the stream so far.
+ */
+Summary SummaryCounter::total(void) const
+{
+    SummaryCounter copy{*this};
+
+    return copy.finish();
+}
+
+/**
+ * @brief Write the counter state on a single line.
+ *
+ * @param os stream to write to.
+ */
+void SummaryCounter::save(std::ostream & os) const
+{
+    os << static_cast<int>(pending) << ' ' << leading << ' ' << inLine << ' ' << space << ' ' << tab;
+    for (const auto & field : fields)
+        os << ' ' << summary.*field.count;
+    os << '\n';
+}
+
+/**
+ * @brief Read the counter state written by save().
+ *
+ * @param is stream to read from.
+ * @return true if the state was read.
+ */
+bool SummaryCounter::load(std::istream & is)
+{
+    int eol{};
+    SummaryCounter loaded{};
+    is >> eol >> loaded.leading >> loaded.inLine >> loaded.space >> loaded.tab;
+    for (const auto & field : fields)
+        is >> loaded.summary.*field.count;
+    if (!is || (eol && eol != '\n' && eol != '\r'))
+        return false;
+
+    loaded.pending = static_cast<char>(eol);
+    *this = loaded;
+
+    return true;
+}
+
+/**
+ * @brief Count the LF characters in a buffer, as 'wc -l' does.
+ *
+ * @param data to count.
+ * @param length of the data in bytes.
+ * @return size_t the number of LF characters.
+ */
+size_t countNewlines(const char * data, size_t length)
+{
+    size_t count{};
+    size_t i{};
+#if defined(__SSE2__)
+    // Matches are subtracted from byte counters, which are summed before
+    // any of them can overflow.
+    const __m128i lf{_mm_set1_epi8('\n')};
+    const __m128i zero{_mm_setzero_si128()};
+    __m128i sums{zero};
+    while (i + 16 <= length)
+    {
+        __m128i counters{zero};
+        const size_t end{std::min(length & ~size_t{15}, i + 255 * 16)};
+        for (; i < end; i += 16)
+        {
+            const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i))};
+            counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(bytes, lf));
+        }
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(counters, zero));
+    }
+    count = _mm_cvtsi128_si64(sums) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+#endif
+    for (; i < length; ++i)
+        if (data[i] == '\n')
+            ++count;
+
+    return count;
+}
+
+/**
+ * @brief Count the LF characters in a file.
+ *
+ * @param fileName of the file to count.
+ * @param lines set to the count.
+ * @return int error value or 0 if no errors.
+ */
+int countFileNewlines(const std::string & fileName, unsigned long long & lines)
+{
+    lines = 0;
+
+    return readBlocks(fileName, [&](const char * data, size_t length) { lines += countNewlines(data, length); });
+}
+
+/**
+ * @brief Produce the summary counts of a file.
+ *
+ * @param fileName of the file to summarise.
+ * @param summary set to the counts.
+ * @return int error value or 0 if no errors.
+ */
+int summariseFile(const std::string & fileName, Summary & summary)
+{
+    SummaryCounter counter{};
+    const int err{readBlocks(fileName, [&](const char * data, size_t length) { counter.add(data, length); })};
+    summary = counter.finish();
+
+    return err;
+}
+
+
+/**
+ * @section summary benchmark implementation.
+ *
+ */
+
+/**
+ * @brief Check the tfc summary of a generated file of each shape against
+ * the in-harness kernel.
+ *
+ * @param dir working directory for the generated files.
+ * @param shapes names of the profiles or pathological shapes to generate.
+ * @param size of the generated input in bytes.
+ * @return int the number of summaries that did not match.
+ */
+int summaryCheck(const std::string & dir, const std::vector<std::string> & shapes, size_t size)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/summary.txt"};
+    const std::string outputFileName{dir + "/summaryOut.txt"};
+
+    int failed{};
+    for (const auto & name : shapes)
+    {
+        const Profile * profile{findProfile(name)};
+        const Shape * shape{findShape(name)};
+        if (profile ? generateFile(inputFileName, *profile, size) :
+            shape ? generateShape(inputFileName, *shape, size) : 1)
+        {
+            std::cerr << "Unable to generate " << name << '\n';
+            ++failed;
+            continue;
+        }
+
+        Usage usage{};
+        if (spawn(tfcPath + " -x -i " + inputFileName + " -o " + outputFileName, usage) ||
+            verifySummary(inputFileName, outputFileName))
+            ++failed;
+    }
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+
+    return failed;
+}
+
+/**
+ * @brief Time 'tfc -x' on a generated file against a 'wc -l' baseline and
+ * the in-harness kernels. The file is read once first so that every
+ * candidate reads it from the page cache.
+ *
+ * @param dir working directory for the generated files.
+ * @param profile name of the generation profile.
+ * @param size of the generated input in bytes.
+ * @param repeat number of timed runs of each, the fastest is kept.
+ * @return int error value or 0 if no errors.
+ */
+int summaryBench(const std::string & dir, const std::string & profile, size_t size, int repeat)
+{
+    const Profile * found{findProfile(profile)};
+    if (!found)
+    {
+        std::cerr << "Unknown profile " << profile << '\n';
+
+        return 1;
+    }
+
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/summary.txt"};
+    const std::string outputFileName{dir + "/summaryOut.txt"};
+    if (generateFile(inputFileName, *found, size))
+        return 1;
+
+    const double bytes = std::filesystem::file_size(inputFileName);
+    double read{};
+    double wc{};
+    double newlines{};
+    double kernel{};
+    double tfc{};
+    int err{};
+    auto fastest = [](double & best, double seconds) { if (!best || seconds < best) best = seconds; };
+    for (int run = 0; run < repeat && !err; ++run)
+    {
+        Stopwatch readClock{};
+        err |= readBlocks(inputFileName, [](const char *, size_t) {});
+        fastest(read, readClock.elapsed());
+
+        Usage usage{};
+        err |= spawn("wc -l < " + inputFileName + " > " + outputFileName, usage);
+        fastest(wc, usage.elapsed);
+
+        unsigned long long lines{};
+        Stopwatch newlineClock{};
+        err |= countFileNewlines(inputFileName, lines);
+        fastest(newlines, newlineClock.elapsed());
+
+        Summary summary{};
+        Stopwatch kernelClock{};
+        err |= summariseFile(inputFileName, summary);
+        fastest(kernel, kernelClock.elapsed());
+
+        err |= spawn(tfcPath + " -x -i " + inputFileName + " -o " + outputFileName, usage);
+        fastest(tfc, usage.elapsed);
+    }
+    err |= verifySummary(inputFileName, outputFileName);
+
+    auto rate = [bytes](double seconds) { return seconds ? bytes / static_cast<double>(MiB) / seconds : 0; };
+    std::cout << std::setw(8) << profile << std::fixed << std::setprecision(1)
+        << std::setw(10) << rate(read) << std::setw(10) << rate(wc) << std::setw(10) << rate(newlines)
+        << std::setw(10) << rate(kernel) << std::setw(10) << rate(tfc)
+        << std::setw(8) << (tfc ? 100 * wc / tfc : 0) << '%' << std::setw(8) << (tfc ? 100 * kernel / tfc : 0) << "%\n";
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the summary benchmark.
+ *
+ *   test summary [--check] [--size S] [--repeat N] [--profile name]...
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "summary".
+ * @return int error value or 0 if no errors.
+ */
+int summaryCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    size_t size{256 << 20};
+    int repeat{3};
+    bool check{};
+    std::vector<std::string> profiles{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--check")
+            check = true;
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], repeat, 1);
+        else if (args[i] == "--profile" && value)
+            profiles.push_back(args[++i]);
+        else
+        {
+            std::cerr << "Unknown summary argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+    if (check)
+    {
+        if (profiles.empty())
+        {
+            profiles = summaryProfiles;
+            const auto shapes{shapeNames()};
+            profiles.insert(profiles.end(), shapes.begin(), shapes.end());
+        }
+        const int failed{summaryCheck(dir, profiles, size)};
+        std::cout << "\n" << profiles.size() - failed << " of " << profiles.size() << " summaries matched the in-harness kernel.\n";
+
+        return failed ? 1 : 0;
+    }
+
+    if (profiles.empty())
+        profiles = summaryProfiles;
+
+    std::cout << "\nSummary throughput in MiB/s on " << size << " byte files from the page cache, fastest of " << repeat << " runs.\n";
+    std::cout << "Read is the harness reading the file, LF count and Summary are the in-harness kernels.\n";
+    std::cout << std::setw(8) << "Profile" << std::setw(10) << "Read" << std::setw(10) << "wc -l" << std::setw(10) << "LF count"
+        << std::setw(10) << "Summary" << std::setw(10) << "tfc -x" << std::setw(9) << "of wc" << std::setw(9) << "of kern" << '\n';
+
+    int err{};
+    for (const auto & profile : profiles)
+        err |= summaryBench(dir, profile, size, repeat);
+
+    return err;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file    summary.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * In-harness line counting and summary kernels, and the '-x' throughput
+ * benchmark built on them.
+ */
+
+#if !defined(_SUMMARY_H__20261017_1700__INCLUDED_)
+#define _SUMMARY_H__20261017_1700__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+
+/**
+ * @section summary kernel interface.
+ *
+ * SummaryCounter produces the same counts as 'tfc -x' from a stream of
+ * blocks of any size. A line ends at "\r\n" (Dos), "\n" (Unix), or at
+ * "\n\r" or a CR on its own (Malformed), and a last line without an EOL is
+ * counted but has no line ending. A line beginning is classified by the
+ * spaces and tabs before the first other character.
+ *
+ * parseSummary() reads either form of the tfc report, the compact form of
+ * the path followed by a line of the 8 counts, or the labelled form with a
+ * "Total Lines:", "Space only:" etc. line for each count.
+ *
+ * A SummaryCounter can be saved part way through a stream and loaded later
+ * to carry on counting from the same byte, without finishing the stream.
+ */
+
+struct Summary
+{
+    unsigned long long lines{};
+    unsigned long long space{};     // Leading whitespace of spaces only.
+    unsigned long long tab{};       // Tabs only.
+    unsigned long long neither{};   // No leading whitespace.
+    unsigned long long both{};      // Spaces and tabs.
+    unsigned long long dos{};
+    unsigned long long unix{};
+    unsigned long long malformed{};
+
+    bool operator==(const Summary & other) const;
+    bool operator!=(const Summary & other) const { return !(*this == other); }
+    Summary operator*(unsigned long long factor) const;
+    std::string counts(void) const;
+};
+
+class SummaryCounter
+{
+public:
+    void add(const char * data, size_t length);
+    const Summary & finish(void);
+    Summary total(void) const;
+
+    void save(std::ostream & os) const;
+    bool load(std::istream & is);
+
+private:
+    enum Eol { DOS, UNIX, MALFORMED, NO_EOL };
+    void endLine(Eol eol);
+
+    Summary summary{};
+    char pending{};     // EOL character ending the last block, waiting on the next byte.
+    bool leading{true}; // Still in the leading whitespace of the current line.
+    bool inLine{};      // The current line has content.
+    bool space{};
+    bool tab{};
+
+};
+
+extern int parseSummary(const std::string & text, std::string & path, Summary & summary);
+extern std::string summaryDifferences(const Summary & actual, const Summary & expected);
+extern int verifySummary(const std::string & inputFileName, const std::string & summaryFileName);
+extern int verifySummary(const std::string & inputFileName, const std::string & summaryFileName, const Summary & expected);
+
+extern size_t findEol(const char * data, size_t i, size_t length);
+extern size_t countNewlines(const char * data, size_t length);
+extern int countFileNewlines(const std::string & fileName, unsigned long long & lines);
+extern int summariseFile(const std::string & fileName, Summary & summary);
+
+
+/**
+ * @section summary benchmark interface.
+ *
+ */
+
+extern int summaryCheck(const std::string & dir, const std::vector<std::string> & shapes, size_t size);
+extern int summaryBench(const std::string & dir, const std::string & profile, size_t size, int repeat);
+extern int summaryCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+#endif // !defined(_SUMMARY_H__20261017_1700__INCLUDED_)
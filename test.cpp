@@ -32,10 +32,33 @@
  */
 
 #include <iostream>
+#include <sstream>
 #include <vector>
+#include <algorithm>
+#include <tuple>
 
 #include "TextFile.h"
 #include "BinaryFile.h"
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "results.h"
+#include "history.h"
+#include "trace.h"
+#include "accounting.h"
+#include "replace.h"
+#include "ab.h"
+#include "complexity.h"
+#include "stress.h"
+#include "fuzz.h"
+#include "minimize.h"
+#include "coreutils.h"
+#include "pipeline.h"
+#include "huge.h"
+#include "summary.h"
+#include "append.h"
+#include "transform.h"
+#include "batch.h"
 
 #include "unittest.h"
 
@@ -47,6 +70,9 @@ const std::string rootDir{"testdata"};
 const std::string inputDir{rootDir + "/input"};
 const std::string outputDir{rootDir + "/output"};
 const std::string expectedDir{rootDir + "/expected"};
+const std::string benchDir{rootDir + "/bench"};
+
+const size_t memoryLimit{256 << 20};
 
 
 static std::vector<std::string> commands{};
@@ -55,7 +81,45 @@ static int execute(const std::string & command)
 {
     commands.push_back(command);
 
-    return system(command.c_str());
+    Usage usage{};
+
+    return spawn(command, usage);
+}
+
+/**
+ * @brief Read the expected and output files and compare them, recording the
+ * read and compare phases of the current test.
+ *
+ * @tparam File BinaryFile or TextFile.
+ * @param expectedFileName of the file containing the expected result.
+ * @param outputFileName of the file generated by tfc.
+ * @return true if the files match.
+ */
+template<class File>
+static bool compareFiles(const std::string & expectedFileName, const std::string & outputFileName)
+{
+    namespace fs = std::filesystem;
+
+    const double readStart{traceClock()};
+    Stopwatch readClock{};
+    File expected{expectedFileName};
+    expected.read();
+    File output{outputFileName};
+    output.read();
+    size_t bytes{};
+    for (const auto & fileName : { expectedFileName, outputFileName })
+        if (fs::exists(fileName))
+            bytes += fs::file_size(fileName);
+    recordPhase(READ, readClock.elapsed(), bytes);
+    traceEvent("read", "read", readStart, { { "files", expectedFileName + " " + outputFileName } });
+
+    const double compareStart{traceClock()};
+    Stopwatch compareClock{};
+    const bool equal{expected.equal(output)};
+    recordPhase(COMPARE, compareClock.elapsed(), bytes);
+    traceEvent("compare", "compare", compareStart, { { "equal", equal ? "true" : "false" } });
+
+    return equal;
 }
 
 static int displayCommands(void)
@@ -122,14 +186,10 @@ UNIT_TEST(test1, "Test summary generation for 'test1.txt'.")
     std::string inputFileName{inputDir + fileName};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -x -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -x -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -139,14 +199,10 @@ UNIT_TEST(test2, "Test summary generation for 'test2.txt'.")
     std::string inputFileName{inputDir + fileName};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -x -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -x -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -156,14 +212,10 @@ UNIT_TEST(test3, "Test summary generation for 'test3.txt'.")
     std::string inputFileName{inputDir + fileName};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -x -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -x -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -173,14 +225,10 @@ UNIT_TEST(test4, "Test summary generation for 'test4.txt'.")
     std::string inputFileName{inputDir + fileName};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -x -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -x -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -196,14 +244,10 @@ UNIT_TEST(test1s, "Test leading space generation for 'test1.txt'.")
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -213,14 +257,10 @@ UNIT_TEST(test2s, "Test leading space generation for 'test2.txt'.")
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -230,14 +270,10 @@ UNIT_TEST(test3s, "Test leading space generation for 'test3.txt'.")
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -247,14 +283,10 @@ UNIT_TEST(test4s, "Test leading space generation for 'test4.txt'.")
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -270,14 +302,10 @@ UNIT_TEST(test1t, "Test leading tab generation for 'test1.txt'.")
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -287,14 +315,10 @@ UNIT_TEST(test2t, "Test leading tab generation for 'test2.txt'.")
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -304,14 +328,10 @@ UNIT_TEST(test3t, "Test leading tab generation for 'test3.txt'.")
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -321,14 +341,10 @@ UNIT_TEST(test4t, "Test leading tab generation for 'test4.txt'.")
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -344,14 +360,10 @@ UNIT_TEST(test1d, "Test trailing dos generation for 'test1.txt'.")
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -361,14 +373,10 @@ UNIT_TEST(test2d, "Test trailing dos generation for 'test2.txt'.")
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -378,14 +386,10 @@ UNIT_TEST(test3d, "Test trailing dos generation for 'test3.txt'.")
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -395,14 +399,10 @@ UNIT_TEST(test4d, "Test trailing dos generation for 'test4.txt'.")
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -418,14 +418,10 @@ UNIT_TEST(test1u, "Test trailing unix generation for 'test1.txt'.")
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -435,14 +431,10 @@ UNIT_TEST(test2u, "Test trailing unix generation for 'test2.txt'.")
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -452,14 +444,10 @@ UNIT_TEST(test3u, "Test trailing unix generation for 'test3.txt'.")
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -469,14 +457,10 @@ UNIT_TEST(test4u, "Test trailing unix generation for 'test4.txt'.")
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -492,14 +476,10 @@ UNIT_TEST(test1sd, "Test leading space and trailing dos generation for 'test1.tx
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -509,14 +489,10 @@ UNIT_TEST(test2sd, "Test leading space and trailing dos generation for 'test2.tx
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -526,14 +502,10 @@ UNIT_TEST(test3sd, "Test leading space and trailing dos generation for 'test3.tx
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -543,14 +515,10 @@ UNIT_TEST(test4sd, "Test leading space and trailing dos generation for 'test4.tx
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -566,14 +534,10 @@ UNIT_TEST(test1td, "Test leading tab and trailing dos generation for 'test1.txt'
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -583,14 +547,10 @@ UNIT_TEST(test2td, "Test leading tab and trailing dos generation for 'test2.txt'
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -600,14 +560,10 @@ UNIT_TEST(test3td, "Test leading tab and trailing dos generation for 'test3.txt'
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -617,14 +573,10 @@ UNIT_TEST(test4td, "Test leading tab and trailing dos generation for 'test4.txt'
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -d -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -d -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -640,14 +592,10 @@ UNIT_TEST(test1su, "Test leading space and trailing unix generation for 'test1.t
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -657,14 +605,10 @@ UNIT_TEST(test2su, "Test leading space and trailing unix generation for 'test2.t
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -674,14 +618,10 @@ UNIT_TEST(test3su, "Test leading space and trailing unix generation for 'test3.t
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -691,14 +631,10 @@ UNIT_TEST(test4su, "Test leading space and trailing unix generation for 'test4.t
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -714,14 +650,10 @@ UNIT_TEST(test1tu, "Test leading tab and trailing unix generation for 'test1.txt
     std::string inputFileName{inputDir + "/test1.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -731,14 +663,10 @@ UNIT_TEST(test2tu, "Test leading tab and trailing unix generation for 'test2.txt
     std::string inputFileName{inputDir + "/test2.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -748,14 +676,10 @@ UNIT_TEST(test3tu, "Test leading tab and trailing unix generation for 'test3.txt
     std::string inputFileName{inputDir + "/test3.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -765,14 +689,10 @@ UNIT_TEST(test4tu, "Test leading tab and trailing unix generation for 'test4.txt
     std::string inputFileName{inputDir + "/test4.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -u -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -u -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    BinaryFile<> expected{expectedDir + fileName};
-    expected.read();
-    BinaryFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -788,14 +708,10 @@ UNIT_TEST(testSpace2, "Test leading space to tab replacement 'testSpace2.txt'.")
     std::string inputFileName{inputDir + "/testSpace.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -2 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -2 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -805,14 +721,10 @@ UNIT_TEST(testSpace4, "Test leading space to tab replacement 'testSpace4.txt'.")
     std::string inputFileName{inputDir + "/testSpace.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -4 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -4 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -822,14 +734,10 @@ UNIT_TEST(testSpace8, "Test leading space to tab replacement 'testSpace8.txt'.")
     std::string inputFileName{inputDir + "/testSpace.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -t -8 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -t -8 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -845,14 +753,10 @@ UNIT_TEST(testTab2, "Test leading space to tab replacement 'testTab2.txt'.")
     std::string inputFileName{inputDir + "/testTab.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -2 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -2 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -862,14 +766,10 @@ UNIT_TEST(testTab4, "Test leading space to tab replacement 'testTab4.txt'.")
     std::string inputFileName{inputDir + "/testTab.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -4 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -4 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -879,14 +779,10 @@ UNIT_TEST(testTab8, "Test leading space to tab replacement 'testTab8.txt'.")
     std::string inputFileName{inputDir + "/testTab.txt"};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc -s -8 -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " -s -8 -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)
 
-    TextFile<> expected{expectedDir + fileName};
-    expected.read();
-    TextFile<> output{outputFileName};
-    output.read();
-    REQUIRE(expected.equal(output))
+    REQUIRE(compareFiles<TextFile<>>(expectedDir + fileName, outputFileName))
 
 END_TEST
 
@@ -898,41 +794,41 @@ END_TEST
 
 UNIT_TEST(testOptions0, "Test invalid option.")
 
-    std::string command{"tfc -z"};
+    std::string command{tfcPath + " -z"};
     REQUIRE(execute(command) != 0)
 
 END_TEST
 
 UNIT_TEST(testOptions1, "Test help option (both '-h' and '--help').")
 
-    std::string command{"tfc -h"};
+    std::string command{tfcPath + " -h"};
     REQUIRE(execute(command) == 0)
 
-    command = "tfc --help";
+    command = tfcPath + " --help";
     REQUIRE(execute(command) == 0)
 
 END_TEST
 
 UNIT_TEST(testOptions2, "Test version option (both '-v' and '--version').")
 
-    std::string command{"tfc -v"};
+    std::string command{tfcPath + " -v"};
     REQUIRE(execute(command) == 0)
 
-    command = "tfc --version";
+    command = tfcPath + " --version";
     REQUIRE(execute(command) == 0)
 
 END_TEST
 
 UNIT_TEST(testOptions3, "Test incomplete input option.")
 
-    std::string command{"tfc -i"};
+    std::string command{tfcPath + " -i"};
     REQUIRE(execute(command) != 0)
 
 END_TEST
 
 UNIT_TEST(testOptions4, "Test invalid input file.")
 
-    std::string command{"tfc -i zxcv"};
+    std::string command{tfcPath + " -i zxcv"};
     REQUIRE(execute(command) != 0)
 
 END_TEST
@@ -942,10 +838,10 @@ UNIT_TEST(testOptions5, "Test source file replacement with summary (both '-r' an
     std::string fileName{"/testOptions.txt"};
     std::string inputFileName{inputDir + fileName};
 
-    std::string command{"tfc -r " + inputFileName};
+    std::string command{tfcPath + " -r " + inputFileName};
     REQUIRE(execute(command) != 0)
 
-    command = "tfc --replace " + inputFileName;
+    command = tfcPath + " --replace " + inputFileName;
     REQUIRE(execute(command) != 0)
 
 END_TEST
@@ -955,7 +851,7 @@ UNIT_TEST(testOptions6, "Test source file and destination file are the same.")
     std::string fileName{"/testOptions.txt"};
     std::string inputFileName{inputDir + fileName};
 
-    std::string command{"tfc --space --input " + inputFileName + " --output " + inputFileName};
+    std::string command{tfcPath + " --space --input " + inputFileName + " --output " + inputFileName};
     REQUIRE(execute(command) != 0)
 
 END_TEST
@@ -966,10 +862,10 @@ UNIT_TEST(testOptions7, "Test overwriting of existing destination file.")
     std::string inputFileName{inputDir + fileName};
     std::string outputFileName{outputDir + fileName};
 
-    std::string command{"tfc --tab -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " --tab -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)  // Create destination.
 
-    command = "tfc --space -i " + inputFileName + " -o " + outputFileName;
+    command = tfcPath + " --space -i " + inputFileName + " -o " + outputFileName;
     REQUIRE(execute(command) == 0)  // Overwrite destination.
 
 END_TEST
@@ -979,76 +875,563 @@ UNIT_TEST(testOptions8, "Test overwriting of source file (both '-r' and '--repla
     std::string inputFileName{inputDir + "/testOptions.txt"};
     std::string outputFileName{outputDir + "/testOverwrite.txt"};
 
-    std::string command{"tfc --dos -i " + inputFileName + " -o " + outputFileName};
+    std::string command{tfcPath + " --dos -i " + inputFileName + " -o " + outputFileName};
     REQUIRE(execute(command) == 0)  // Create "testOverwrite.txt".
 
-    command = "tfc --unix -r " + outputFileName;
+    command = tfcPath + " --unix -r " + outputFileName;
     REQUIRE(execute(command) == 0)  // Replace "testOverwrite.txt".
 
-    command = "tfc --dos --replace " + outputFileName;
+    command = tfcPath + " --dos --replace " + outputFileName;
     REQUIRE(execute(command) == 0)  // Replace "again testOverwrite.txt".
 
 END_TEST
 
 
-int runTests(const char * program)
+/**
+ * @section test memory ceiling.
+ *
+ */
+
+UNIT_TEST(testMemory1, "Test summary of a file 4 times larger than the memory limit.")
+
+    REQUIRE(memoryCeiling(benchDir, "-x", 4 * memoryLimit, memoryLimit) == 0)
+
+END_TEST
+
+UNIT_TEST(testMemory2, "Test conversion of a file 4 times larger than the memory limit.")
+
+    REQUIRE(memoryCeiling(benchDir, "-s -u", 4 * memoryLimit, memoryLimit) == 0)
+
+END_TEST
+
+UNIT_TEST(testMemory3, "Test peak memory does not grow with input size.")
+
+    REQUIRE(memorySweep(benchDir, 1 << 20, 64 << 20, memoryLimit) == 0)
+
+END_TEST
+
+
+/**
+ * @section test read and write sizes.
+ *
+ */
+
+UNIT_TEST(testIo1, "Test summary reads in blocks rather than lines.")
+
+    REQUIRE(ioCheck(benchDir, "-x", 16 << 20) == 0)
+
+END_TEST
+
+UNIT_TEST(testIo2, "Test conversion reads and writes in blocks rather than lines.")
+
+    REQUIRE(ioCheck(benchDir, "-s -d", 16 << 20) == 0)
+
+END_TEST
+
+
+/**
+ * @section test replace mode.
+ *
+ */
+
+UNIT_TEST(testReplace1, "Test '-r' replaces a large file atomically without doubling the writes.")
+
+    REQUIRE(replaceCheck(benchDir, "-u", 32 << 20) == 0)
+
+END_TEST
+
+UNIT_TEST(testReplace2, "Test '--replace' with conversion replaces a large file atomically.")
+
+    REQUIRE(replaceCheck(benchDir, "-t -d", 32 << 20, "--replace") == 0)
+
+END_TEST
+
+
+/**
+ * @section test algorithmic complexity.
+ *
+ */
+
+UNIT_TEST(testComplexity1, "Test conversion memory scales linearly with line length, reporting the time scaling.")
+
+    REQUIRE(complexitySweep(benchDir, "length", "-t -d", 4 << 20, 64 << 20, false) == 0)
+
+END_TEST
+
+UNIT_TEST(testComplexity2, "Test conversion memory scales linearly with indentation depth, reporting the time scaling.")
+
+    REQUIRE(complexitySweep(benchDir, "indent", "-s -u", 4 << 20, 64 << 20, false) == 0)
+
+END_TEST
+
+
+/**
+ * @section test pathological inputs.
+ *
+ */
+
+UNIT_TEST(testStress1, "Test summary of every pathological shape within the time and memory limits.")
+
+    REQUIRE(stressCheck(benchDir, "-x", 16 << 20) == 0)
+
+END_TEST
+
+UNIT_TEST(testStress2, "Test conversion of every pathological shape within the time and memory limits.")
+
+    REQUIRE(stressCheck(benchDir, "-s -d", 16 << 20) == 0)
+
+END_TEST
+
+
+/**
+ * @section test against coreutils.
+ *
+ */
+
+UNIT_TEST(testCoreutils1, "Test leading whitespace conversion matches coreutils expand and unexpand.")
+
+    REQUIRE(coreutilsCompare(benchDir, "mixed", 1 << 20, 1) == 0)
+
+END_TEST
+
+
+/**
+ * @section test combined against chained invocations.
+ *
+ */
+
+UNIT_TEST(testPipeline1, "Test combined options give the same output as chaining single option invocations.")
+
+    REQUIRE(pipelineCompare(benchDir, "mixed", { { "-s -d", { "-s", "-d" } }, { "-t -u -8", { "-t -8", "-u" } } }, 1 << 20, 1) == 0)
+
+END_TEST
+
+
+/**
+ * @section test huge files.
+ *
+ */
+
+UNIT_TEST(testHuge1, "Test summary and conversion of a tiled file are verified against the tile.")
+
+    REQUIRE(hugeCheck(benchDir, "lines", { "-x", "-s -d" }, 16 << 20) == 0)
+    REQUIRE(hugeCheck(benchDir, "bytes", { "-x", "-t -u -8" }, 16 << 20) == 0)
+
+END_TEST
+
+
+/**
+ * @section test summary kernels.
+ *
+ */
+
+UNIT_TEST(testSummary1, "Test the in-harness summary kernel matches the expected summaries.")
+
+    for (const auto & fileName : { "/test1.txt", "/test2.txt", "/test3.txt", "/test4.txt" })
+    {
+        Summary summary{};
+        REQUIRE(summariseFile(inputDir + fileName, summary) == 0)
+
+        TextFile<> expected{expectedDir + fileName};
+        expected.read();
+        REQUIRE(expected.size() == 2)
+        REQUIRE(summary.counts() == expected.getData()[1])
+    }
+
+END_TEST
+
+UNIT_TEST(testSummary2, "Test the in-harness kernels give the same counts whatever the block boundaries.")
+
+    const std::string text{" \t a\r\n\tb\n\r\r\r\n  \n\n\rc\r\n\t \t"};
+    SummaryCounter counter{};
+    counter.add(text.data(), text.size());
+    const Summary whole{counter.finish()};
+    REQUIRE(whole.counts() == "8 1 1 4 2 3 1 3")
+    REQUIRE(countNewlines(text.data(), text.size()) == static_cast<size_t>(std::count(text.begin(), text.end(), '\n')))
+
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        SummaryCounter parts{};
+        parts.add(text.data(), split);
+        parts.add(text.data() + split, text.size() - split);
+        REQUIRE(parts.finish() == whole)
+    }
+
+END_TEST
+
+
+UNIT_TEST(testSummary3, "Test the compact and labelled summary reports parse to the same counts.")
+
+    const std::string compact{"testdata/input/test3.txt\n9 1 1 3 4 6 3 0\n"};
+    const std::string labelled{"testdata/input/test3.txt\n  Total Lines:  9\nLine begining:\n  Space only:   1\n"
+        "  Tab only:     1\n  Neither:      3\n  Both:         4\nLine ending:\n  Dos:          6\n  Unix:         3\n"
+        "  Malformed:    0\n"};
+
+    std::string path{};
+    Summary lhs{};
+    Summary rhs{};
+    REQUIRE(parseSummary(compact, path, lhs) == 0)
+    REQUIRE(path == "testdata/input/test3.txt")
+    REQUIRE(parseSummary(labelled, path, rhs) == 0)
+    REQUIRE(path == "testdata/input/test3.txt")
+    REQUIRE(lhs == rhs)
+    REQUIRE(lhs.counts() == "9 1 1 3 4 6 3 0")
+
+    rhs.dos = 5;
+    REQUIRE(summaryDifferences(rhs, lhs) == "Dos 5 expected 6")
+    REQUIRE(parseSummary("testdata/input/test3.txt\n9 1 1\n", path, lhs) == 1)
+
+END_TEST
+
+UNIT_TEST(testSummary4, "Test the summary of every profile and shape matches the in-harness kernel.")
+
+    std::vector<std::string> shapes{ "dos", "unix", "malformed", "mixed", "all", "indent", "long" };
+    for (const auto & shape : shapeNames())
+        shapes.push_back(shape);
+
+    REQUIRE(summaryCheck(benchDir, shapes, 4 << 20) == 0)
+
+END_TEST
+
+
+/**
+ * @section test append aware summaries.
+ *
+ */
+
+UNIT_TEST(testAppend1, "Test a growing log is checked by counting only the appended bytes.")
+
+    REQUIRE(appendSimulate(benchDir, 4 << 20, 8) == 0)
+
+END_TEST
+
+UNIT_TEST(testAppend2, "Test a checkpoint saved mid-line continues to the same counts.")
+
+    const std::string text{" \t a\r\n\tb\n\r\r\r\n  \n\n\rc\r\n\t \t"};
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        SummaryCounter first{};
+        first.add(text.data(), split);
+        std::stringstream ss{};
+        first.save(ss);
+
+        SummaryCounter second{};
+        REQUIRE(second.load(ss))
+        second.add(text.data() + split, text.size() - split);
+        REQUIRE(second.finish().counts() == "8 1 1 4 2 3 1 3")
+    }
+
+END_TEST
+
+
+/**
+ * @section test reference transform.
+ *
+ */
+
+UNIT_TEST(testTransform1, "Test the reference transform reproduces the tab and space conversion fixtures.")
+
+    for (const auto & [input, options, expected] : {
+        std::tuple{ "/testSpace.txt", "-t -2", "/testSpace2.txt" }, { "/testSpace.txt", "-t -4", "/testSpace4.txt" },
+        { "/testSpace.txt", "-t -8", "/testSpace8.txt" }, { "/testTab.txt", "-s -2", "/testTab2.txt" },
+        { "/testTab.txt", "-s -4", "/testTab4.txt" }, { "/testTab.txt", "-s -8", "/testTab8.txt" } })
+    {
+        const std::string outputFileName{outputDir + expected};
+        REQUIRE(transformFile(inputDir + input, outputFileName, options) == 0)
+        REQUIRE(compareFiles<BinaryFile<>>(expectedDir + expected, outputFileName))
+    }
+
+END_TEST
+
+UNIT_TEST(testTransform2, "Test the compile time and runtime tab sizes agree and match tfc.")
+
+    const std::string text{" \t a\r\n\t  b\n\r \t\r   \t\tc\t \r\n\n  \t"};
+    for (const bool toTabs : { false, true })
+        for (const size_t tabSize : { 2, 4, 8 })
+        {
+            std::string fixed{};
+            std::string runtime{};
+            transformBuffer(toTabs, tabSize, text.data(), text.size(), fixed);
+            LeadingTransform<RuntimeTab> transform{toTabs, RuntimeTab{tabSize}};
+            transform.add(text.data(), text.size(), runtime);
+            transform.finish(runtime);
+            REQUIRE(fixed == runtime)
+        }
+
+    REQUIRE(transformCheck(benchDir, { "all", "indent" }, 1 << 20) == 0)
+
+END_TEST
+
+
+UNIT_TEST(testTransform3, "Test the reference transform and EOL kernels reproduce the conversion fixtures.")
+
+    for (const auto & [suffix, options] : { std::pair{ "s", "-s" }, { "t", "-t" }, { "d", "-d" }, { "u", "-u" },
+        { "sd", "-s -d" }, { "td", "-t -d" }, { "su", "-s -u" }, { "tu", "-t -u" } })
+        for (const auto & test : { "/test1", "/test2", "/test3", "/test4" })
+        {
+            const std::string fileName{std::string{test} + suffix + ".txt"};
+            REQUIRE(transformFile(inputDir + test + ".txt", outputDir + fileName, options) == 0)
+            REQUIRE(compareFiles<BinaryFile<>>(expectedDir + fileName, outputDir + fileName))
+        }
+
+    const std::vector<char> text{ 'a', '\n', 'b', '\r', '\n', 'c', '\n', '\r', 'd', '\r', '\r', '\n', 'e' };
+    const std::vector<char> dos{ 'a', '\r', '\n', 'b', '\r', '\n', 'c', '\r', '\n', 'd', '\r', '\n', '\r', '\n', 'e' };
+    const std::vector<char> unix{ 'a', '\n', 'b', '\n', 'c', '\n', 'd', '\n', '\n', 'e' };
+    REQUIRE(normaliseEols(text, TO_DOS) == dos)
+    REQUIRE(normaliseEols(text, TO_UNIX) == unix)
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        EolNormaliser normaliser{TO_DOS};
+        std::vector<char> out(EolNormaliser::space(text.size()));
+        size_t written{normaliser.add(text.data(), split, out.data())};
+        written += normaliser.add(text.data() + split, text.size() - split, out.data() + written);
+        written += normaliser.finish(out.data() + written);
+        out.resize(written);
+        REQUIRE(out == dos)
+    }
+
+END_TEST
+
+
+UNIT_TEST(testTransform4, "Test the parallel reference transform matches the sequential one across chunk boundaries.")
+
+    const std::string inputFileName{benchDir + "/parallel.txt"};
+    const std::string sequentialFileName{benchDir + "/parallelSequential.txt"};
+    const std::string parallelFileName{benchDir + "/parallelOut.txt"};
+    for (const auto & shape : { "alternate", "cr", "wide" })
+    {
+        REQUIRE(generateShape(inputFileName, *findShape(shape), 1 << 20) == 0)
+        for (const auto & options : { "-s -d", "-t -u -2" })
+        {
+            REQUIRE(transformFile(inputFileName, sequentialFileName, options) == 0)
+            REQUIRE(transformFileParallel(inputFileName, parallelFileName, options, 4, 4096) == 0)
+            REQUIRE(sameContent(sequentialFileName, parallelFileName))
+        }
+    }
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(sequentialFileName);
+    std::filesystem::remove(parallelFileName);
+
+END_TEST
+
+
+UNIT_TEST(testBatch1, "Test the batch summary check of a generated directory tree.")
+
+    const std::string root{benchDir + "/batchTree"};
+    REQUIRE(batchGenerate(root, 40, 4096) == 0)
+
+    BatchReport report{};
+    REQUIRE(batchCheck(root, benchDir, 4, 2, report) == 0)
+    REQUIRE(report.files == 40)
+    REQUIRE(report.mismatches == 0)
+    REQUIRE(report.errors == 0)
+    REQUIRE(report.failed.empty())
+
+    std::filesystem::remove_all(root);
+
+END_TEST
+
+
+UNIT_TEST(testGenerate1, "Test an interrupted generation resumes from its journal and gives the same bytes.")
+
+    const size_t interval{checkpointInterval};
+    checkpointInterval = 1 << 20;
+    const std::string fileName{benchDir + "/resume.txt"};
+    const std::string journalFileName{fileName + ".journal"};
+    const std::string freshFileName{benchDir + "/fresh.txt"};
+    const Profile & profile{*findProfile("all")};
+    std::filesystem::remove(fileName);
+    std::filesystem::remove(journalFileName);
+
+    REQUIRE(interruptGeneration(fileName, profile, 6 << 20, 3 << 20, 7) == 0)
+    REQUIRE(std::filesystem::exists(journalFileName))
+    {
+        std::ofstream os{fileName, std::ios::binary|std::ios::app};
+        os << "bytes written after the last checkpoint";
+    }
+    REQUIRE(generateFile(fileName, profile, 6 << 20, 7) == 0)
+    REQUIRE(!std::filesystem::exists(journalFileName))
+    REQUIRE(generateFile(freshFileName, profile, 6 << 20, 7) == 0)
+    REQUIRE(sameContent(fileName, freshFileName))
+
+    // A journal for a different seed is ignored.
+    REQUIRE(interruptGeneration(fileName, profile, 6 << 20, 3 << 20, 8) == 0)
+    REQUIRE(generateFile(fileName, profile, 6 << 20, 7) == 0)
+    REQUIRE(sameContent(fileName, freshFileName))
+
+    // So is a journal for a profile of the same name with other parameters.
+    const Profile renamed{profile.name, profile.indent + 4, profile.length / 2, "u"};
+    REQUIRE(interruptGeneration(fileName, renamed, 6 << 20, 3 << 20, 7) == 0)
+    REQUIRE(std::filesystem::exists(journalFileName))
+    REQUIRE(generateFile(fileName, profile, 6 << 20, 7) == 0)
+    REQUIRE(sameContent(fileName, freshFileName))
+
+    std::filesystem::remove(fileName);
+    std::filesystem::remove(journalFileName);
+    std::filesystem::remove(freshFileName);
+    checkpointInterval = interval;
+
+END_TEST
+
+
+UNIT_TEST(testMinimize1, "Test a minimized input is written as a fixture with every awkward byte escaped.")
+
+    const std::string input{'a', '\'', '\\', '\0', '\r', '\xe9', '\n', 'b'};
+    const std::string expected{"/* Awkward bytes.\ntestdata/input/testMin1.txt\n*/\n"
+        "    std::vector<char> testMin1{ \n"
+        "        'a', '\\'', '\\\\', '\\0', '\\r', '\\xe9', '\\n', \n"
+        "        'b' \n"
+        "    };\n"
+        "    filename = \"/testMin1.txt\";\n"
+        "    input.setFileName(inputDir + filename);\n"
+        "    input.write(testMin1);\n"};
+    REQUIRE(fixtureCode("testMin1", input, "Awkward bytes.") == expected)
+
+END_TEST
+
+UNIT_TEST(testMinimize2, "Test the minimizer reduces a failing input to a 1-minimal one.")
+
+    // A stand-in for tfc that fails whenever its input holds both an X and a Y.
+    const std::string dir{benchDir + "/minimize"};
+    const std::string stub{dir + "/failXY.sh"};
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream os{stub};
+        os << "#!/bin/sh\nwhile [ $# -gt 0 ]; do [ \"$1\" = -i ] && in=$2; shift; done\n"
+            << "grep -q X \"$in\" && grep -q Y \"$in\" && exit 1\nexit 0\n";
+    }
+    std::filesystem::permissions(stub, std::filesystem::perms::owner_all);
+
+    const std::string original{tfcPath};
+    tfcPath = stub;
+    const Predicate predicate{};
+    const std::string input{"first line\nan X here\n\tpadding\r\nmore padding\nand a Y there\nlast line\n"};
+    REQUIRE(interesting(dir, predicate, input))
+    const std::string reduced{minimize(dir, predicate, input, 2)};
+    REQUIRE(reduced.size() == 2)
+    for (size_t i = 0; i < reduced.size(); ++i)
+        REQUIRE(!interesting(dir, predicate, reduced.substr(0, i) + reduced.substr(i + 1)))
+    tfcPath = original;
+
+    std::filesystem::remove_all(dir);
+
+END_TEST
+
+
+/**
+ * @section test A/B comparison.
+ *
+ */
+
+UNIT_TEST(testAb1, "Test A/B comparison of tfc with itself gives identical output.")
+
+    AbConfig config{tfcPath, tfcPath, 1 << 20, 3, { "all" }};
+    REQUIRE(abCompare(benchDir, config) == 0)
+
+    config.repeat = 1;
+    REQUIRE(abCompare(benchDir, config) == 1)
+
+END_TEST
+
+
+/**
+ * @section test execution.
+ *
+ * Each test is timed independently of the unit test framework so that
+ * per-phase timings can be exported, while TIMINGS_OFF keeps the framework
+ * output stable for comparison.
+ */
+
+#define RUN_TIMED(func) startTest(#func); RUN_TEST(func) stopTest(FINISHED);
+
+int runTests(const char * program, const std::string & junitFileName, const std::string & jsonFileName, bool detail)
 {
     std::cout << "\nExecuting all tests.\n";
 
     TIMINGS_OFF
 
-    RUN_TEST(test0)
-    RUN_TEST(test1)
-    RUN_TEST(test2)
-    RUN_TEST(test3)
-    RUN_TEST(test4)
-    RUN_TEST(test1s)
-    RUN_TEST(test2s)
-    RUN_TEST(test3s)
-    RUN_TEST(test4s)
-    RUN_TEST(test1t)
-    RUN_TEST(test2t)
-    RUN_TEST(test3t)
-    RUN_TEST(test4t)
-    RUN_TEST(test1d)
-    RUN_TEST(test2d)
-    RUN_TEST(test3d)
-    RUN_TEST(test4d)
-    RUN_TEST(test1u)
-    RUN_TEST(test2u)
-    RUN_TEST(test3u)
-    RUN_TEST(test4u)
-    RUN_TEST(test1sd)
-    RUN_TEST(test2sd)
-    RUN_TEST(test3sd)
-    RUN_TEST(test4sd)
-    RUN_TEST(test1td)
-    RUN_TEST(test2td)
-    RUN_TEST(test3td)
-    RUN_TEST(test4td)
-    RUN_TEST(test1su)
-    RUN_TEST(test2su)
-    RUN_TEST(test3su)
-    RUN_TEST(test4su)
-    RUN_TEST(test1tu)
-    RUN_TEST(test2tu)
-    RUN_TEST(test3tu)
-    RUN_TEST(test4tu)
-    RUN_TEST(testSpace2)
-    RUN_TEST(testSpace4)
-    RUN_TEST(testSpace8)
-    RUN_TEST(testTab2)
-    RUN_TEST(testTab4)
-    RUN_TEST(testTab8)
-    RUN_TEST(testOptions0)
-    RUN_TEST(testOptions1)
-    RUN_TEST(testOptions2)
-    RUN_TEST(testOptions3)
-    RUN_TEST(testOptions4)
-    RUN_TEST(testOptions5)
-    RUN_TEST(testOptions6)
-    RUN_TEST(testOptions7)
-    RUN_TEST(testOptions8)
+    RUN_TIMED(test0)
+    RUN_TIMED(test1)
+    RUN_TIMED(test2)
+    RUN_TIMED(test3)
+    RUN_TIMED(test4)
+    RUN_TIMED(test1s)
+    RUN_TIMED(test2s)
+    RUN_TIMED(test3s)
+    RUN_TIMED(test4s)
+    RUN_TIMED(test1t)
+    RUN_TIMED(test2t)
+    RUN_TIMED(test3t)
+    RUN_TIMED(test4t)
+    RUN_TIMED(test1d)
+    RUN_TIMED(test2d)
+    RUN_TIMED(test3d)
+    RUN_TIMED(test4d)
+    RUN_TIMED(test1u)
+    RUN_TIMED(test2u)
+    RUN_TIMED(test3u)
+    RUN_TIMED(test4u)
+    RUN_TIMED(test1sd)
+    RUN_TIMED(test2sd)
+    RUN_TIMED(test3sd)
+    RUN_TIMED(test4sd)
+    RUN_TIMED(test1td)
+    RUN_TIMED(test2td)
+    RUN_TIMED(test3td)
+    RUN_TIMED(test4td)
+    RUN_TIMED(test1su)
+    RUN_TIMED(test2su)
+    RUN_TIMED(test3su)
+    RUN_TIMED(test4su)
+    RUN_TIMED(test1tu)
+    RUN_TIMED(test2tu)
+    RUN_TIMED(test3tu)
+    RUN_TIMED(test4tu)
+    RUN_TIMED(testSpace2)
+    RUN_TIMED(testSpace4)
+    RUN_TIMED(testSpace8)
+    RUN_TIMED(testTab2)
+    RUN_TIMED(testTab4)
+    RUN_TIMED(testTab8)
+    RUN_TIMED(testOptions0)
+    RUN_TIMED(testOptions1)
+    RUN_TIMED(testOptions2)
+    RUN_TIMED(testOptions3)
+    RUN_TIMED(testOptions4)
+    RUN_TIMED(testOptions5)
+    RUN_TIMED(testOptions6)
+    RUN_TIMED(testOptions7)
+    RUN_TIMED(testOptions8)
+    RUN_TIMED(testMemory1)
+    RUN_TIMED(testMemory2)
+    RUN_TIMED(testMemory3)
+    RUN_TIMED(testIo1)
+    RUN_TIMED(testIo2)
+    RUN_TIMED(testReplace1)
+    RUN_TIMED(testReplace2)
+    RUN_TIMED(testComplexity1)
+    RUN_TIMED(testComplexity2)
+    RUN_TIMED(testStress1)
+    RUN_TIMED(testStress2)
+    RUN_TIMED(testCoreutils1)
+    RUN_TIMED(testPipeline1)
+    RUN_TIMED(testHuge1)
+    RUN_TIMED(testSummary1)
+    RUN_TIMED(testSummary2)
+    RUN_TIMED(testSummary3)
+    RUN_TIMED(testSummary4)
+    RUN_TIMED(testAppend1)
+    RUN_TIMED(testAppend2)
+    RUN_TIMED(testTransform1)
+    RUN_TIMED(testTransform2)
+    RUN_TIMED(testTransform3)
+    RUN_TIMED(testTransform4)
+    RUN_TIMED(testBatch1)
+    RUN_TIMED(testGenerate1)
+    RUN_TIMED(testMinimize1)
+    RUN_TIMED(testMinimize2)
+    RUN_TIMED(testAb1)
 
     const int err = FINISHED;
     if (!err)
@@ -1058,10 +1441,134 @@ int runTests(const char * program)
         // genTestScript("runTests.sh", program);
     }
     OUTPUT_SUMMARY;
+    outputPhases(detail);
+    outputIoSummary();
+
+    if (!junitFileName.empty() && writeJUnit(junitFileName))
+        std::cerr << "Unable to write " << junitFileName << '\n';
+
+    if (!jsonFileName.empty() && writeJson(jsonFileName))
+        std::cerr << "Unable to write " << jsonFileName << '\n';
 
     return err;
 }
 
+static int usage(const char * program)
+{
+    std::cerr << "Usage:\n";
+    std::cerr << "  " << program << " [--junit file] [--json file] [--detail]  run all tests\n";
+    std::cerr << "Any command also accepts --trace file to write a Chrome/Perfetto trace and\n";
+    std::cerr << "--tfc path to test a tfc other than the one on the PATH.\n";
+    std::cerr << "  " << program << " memory [from [to [limit]]]       peak RSS sweep\n";
+    std::cerr << "  " << program << " bench [--size S] [--repeat N] [--profile name]... [--cache warm|cold|both] [--store file]\n";
+    std::cerr << "          [--cpus list] [--nice N] [--max-noise percent]\n";
+    std::cerr << "  " << program << " history [runs] [--store file]    throughput trends\n";
+    std::cerr << "  " << program << " replace [size]                   replace mode analysis\n";
+    std::cerr << "  " << program << " ab pathA pathB [--size S] [--repeat N] [--profile name]...\n";
+    std::cerr << "  " << program << " stress [size] [--shape name]... [--options \"opts\"]...\n";
+    std::cerr << "  " << program << " fuzz [--iterations N] [--size S] [--seed N] [--threshold X] [--options \"opts\"]... [--corpus dir]\n";
+    std::cerr << "  " << program << " minimize file --options \"opts\" [--oracle path | --slow ns] [--size S]\n";
+    std::cerr << "          [--timeout secs] [--jobs N] [--name fixture] [--fixture file]\n";
+    std::cerr << "  " << program << " transform [--bench] [--size S] [--repeat N] [--profile name]...\n";
+    std::cerr << "  " << program << " transform --parallel [--size S] [--threads N]\n";
+    std::cerr << "  " << program << " generate file [--profile name | --shape name] [--size S] [--seed N]\n";
+    std::cerr << "  " << program << " batch [root] [--threads N] [--queue N] [--files N] [--size S]\n";
+    std::cerr << "  " << program << " append file [--checkpoint path]\n";
+    std::cerr << "  " << program << " append --simulate [--size S] [--steps N]\n";
+    std::cerr << "  " << program << " summary [--check] [--size S] [--repeat N] [--profile name]...\n";
+    std::cerr << "  " << program << " huge [--size S] [--tile lines|bytes]... [--options o]...\n";
+    std::cerr << "  " << program << " pipeline [--size S] [--repeat N] [--profile name]... [--options \"combined\" \"step|step...\"]...\n";
+    std::cerr << "  " << program << " coreutils [--size S] [--repeat N] [--profile name]...\n";
+    std::cerr << "  " << program << " complexity [from [to]] [--dimension lines|length|indent]... [--options \"opts\"]...\n";
+
+    return 1;
+}
+
+/**
+ * @brief Run the command given on the command line, or all the tests if
+ * there is no command.
+ *
+ * @param program name of this executable.
+ * @param args command line arguments.
+ * @return error value or 0 if no errors.
+ */
+static int runCommand(const char * program, const std::vector<std::string> & args)
+{
+    if (!args.empty() && args[0] == "memory")
+        return memoryCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "bench")
+        return benchCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "history")
+        return historyCommand(args);
+
+    if (!args.empty() && args[0] == "replace")
+        return replaceCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "ab")
+        return abCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "complexity")
+        return complexityCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "stress")
+        return stressCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "generate")
+        return generateCommand(args);
+
+    if (!args.empty() && args[0] == "batch")
+        return batchCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "transform")
+        return transformCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "append")
+        return appendCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "summary")
+        return summaryCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "huge")
+        return hugeCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "pipeline")
+        return pipelineCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "coreutils")
+        return coreutilsCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "minimize")
+        return minimizeCommand(benchDir, args);
+
+    if (!args.empty() && args[0] == "fuzz")
+    {
+        init(rootDir, inputDir, outputDir, expectedDir);
+
+        return fuzzCommand(benchDir, inputDir, args);
+    }
+
+    std::string junitFileName{};
+    std::string jsonFileName{};
+    bool detail{};
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i] == "--junit" && i + 1 < args.size())
+            junitFileName = args[++i];
+        else if (args[i] == "--json" && i + 1 < args.size())
+            jsonFileName = args[++i];
+        else if (args[i] == "--detail")
+            detail = true;
+        else
+            return usage(program);
+    }
+
+    init(rootDir, inputDir, outputDir, expectedDir);
+
+    return runTests(program, junitFileName, jsonFileName, detail);
+}
+
 /**
  * Test system entry point.
  *
@@ -1069,12 +1576,26 @@ int runTests(const char * program)
  * @param  argv - command line argument vector.
  * @return error value or 0 if no errors.
  */
-extern int init(const std::string & root, const std::string & input, const std::string & output, const std::string & expected);
-
 int main(int argc, char *argv[])
 {
-    init(rootDir, inputDir, outputDir, expectedDir);
+    std::vector<std::string> args(argv + 1, argv + argc);
+    const auto trace{std::find(args.begin(), args.end(), "--trace")};
+    if (trace != args.end() && trace + 1 != args.end())
+    {
+        startTrace(*(trace + 1));
+        args.erase(trace, trace + 2);
+    }
 
-    return runTests(argv[0]);
-}
+    const auto tfc{std::find(args.begin(), args.end(), "--tfc")};
+    if (tfc != args.end() && tfc + 1 != args.end())
+    {
+        tfcPath = *(tfc + 1);
+        args.erase(tfc, tfc + 2);
+    }
+
+    const int err{runCommand(argv[0], args)};
+    if (writeTrace())
+        std::cerr << "Unable to write trace file\n";
 
+    return err;
+}
@@ -0,0 +1,193 @@
+/**
+ * @file    trace.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Chrome/Perfetto trace-event timeline of a harness run.
+ *
+ * The resulting file can be loaded into chrome://tracing or
+ * https://ui.perfetto.dev.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include <unistd.h>
+
+#include "trace.h"
+
+/**
+ * @section basic utility code.
+ */
+
+struct Event
+{
+    std::string name;
+    const char * category;
+    double start;
+    double duration;
+    int tid;
+    TraceArgs args;
+};
+
+struct ThreadName
+{
+    int tid;
+    std::string name;
+};
+
+static std::string traceFileName{};
+static std::chrono::steady_clock::time_point origin{};
+static std::vector<Event> events{};
+static std::vector<ThreadName> threadNames{};
+static std::mutex eventMutex{};
+static std::atomic<int> nextTid{1};
+
+static int threadId(void)
+{
+    thread_local const int tid{nextTid++};
+
+    return tid;
+}
+
+static std::string escape(const std::string & text)
+{
+    std::string escaped{};
+    for (const auto c : text)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(c) >= ' ')
+            escaped += c;
+    }
+
+    return escaped;
+}
+
+
+/**
+ * @section trace-event implementation.
+ *
+ */
+
+/**
+ * @brief Start recording events, to be written to the named file.
+ *
+ * @param fileName of the trace file.
+ */
+void startTrace(const std::string & fileName)
+{
+    traceFileName = fileName;
+    origin = std::chrono::steady_clock::now();
+    traceThreadName("harness");
+}
+
+bool tracing(void)
+{
+    return !traceFileName.empty();
+}
+
+/**
+ * @brief Get the trace timestamp.
+ *
+ * @return double microseconds since the trace was started.
+ */
+double traceClock(void)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+/**
+ * @brief Record a complete event on the calling thread's track, ending now.
+ *
+ * @param name of the event.
+ * @param category of the event, such as "generate", "execute" or "compare".
+ * @param start timestamp from traceClock().
+ * @param args name/value pairs shown with the event.
+ */
+void traceEvent(const std::string & name, const char * category, double start, const TraceArgs & args)
+{
+    if (!tracing())
+        return;
+
+    const double end{traceClock()};
+    const int tid{threadId()};
+
+    std::lock_guard<std::mutex> lock{eventMutex};
+    events.push_back(Event{name, category, start, end - start, tid, args});
+}
+
+/**
+ * @brief Name the calling thread's track.
+ *
+ * @param name for the track.
+ */
+void traceThreadName(const std::string & name)
+{
+    if (!tracing())
+        return;
+
+    const int tid{threadId()};
+
+    std::lock_guard<std::mutex> lock{eventMutex};
+    threadNames.push_back(ThreadName{tid, name});
+}
+
+/**
+ * @brief Write the recorded events as a trace-event JSON file.
+ *
+ * @return int error value or 0 if no errors.
+ */
+int writeTrace(void)
+{
+    if (!tracing())
+        return 0;
+
+    const pid_t pid{getpid()};
+    std::lock_guard<std::mutex> lock{eventMutex};
+    if (std::ofstream os{traceFileName, std::ios::out})
+    {
+        os << std::fixed << std::setprecision(3);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":0,\"args\":{\"name\":\"tfcTest\"}}";
+        for (const auto & thread : threadNames)
+            os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << thread.tid
+                << ",\"args\":{\"name\":\"" << escape(thread.name) << "\"}}";
+
+        for (const auto & event : events)
+        {
+            os << ",\n{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << event.start
+                << ",\"dur\":" << event.duration << ",\"pid\":" << pid << ",\"tid\":" << event.tid << ",\"args\":{";
+            const char * separator{""};
+            for (const auto & [key, value] : event.args)
+            {
+                os << separator << '"' << escape(key) << "\":\"" << escape(value) << '"';
+                separator = ",";
+            }
+            os << "}}";
+        }
+        os << "\n]}\n";
+
+        return 0;
+    }
+
+    return 1;
+}
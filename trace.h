@@ -0,0 +1,51 @@
+/**
+ * @file    trace.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Chrome/Perfetto trace-event timeline of a harness run.
+ */
+
+#if !defined(_TRACE_H__20261017_1100__INCLUDED_)
+#define _TRACE_H__20261017_1100__INCLUDED_
+
+#include <string>
+#include <vector>
+#include <utility>
+
+
+/**
+ * @section trace-event interface.
+ *
+ * Events are complete ("X") events timed in microseconds from the start of
+ * the trace. Each thread that records an event gets its own track, so
+ * parallel workers appear side by side. Recording is a no-op until
+ * startTrace() has been called.
+ */
+
+using TraceArgs = std::vector<std::pair<std::string, std::string>>;
+
+extern void startTrace(const std::string & fileName);
+extern bool tracing(void);
+extern double traceClock(void);
+extern void traceEvent(const std::string & name, const char * category, double start, const TraceArgs & args = TraceArgs{});
+extern void traceThreadName(const std::string & name);
+extern int writeTrace(void);
+
+
+#endif // !defined(_TRACE_H__20261017_1100__INCLUDED_)
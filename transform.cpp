@@ -0,0 +1,623 @@
+/**
+ * @file    transform.cpp
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Reference leading whitespace transform, specialised at compile time for
+ * each tab size.
+ *
+ * Reference output for generated inputs is produced in the harness and
+ * compared with tfc, rather than precomputed.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gen.h"
+#include "spawn.h"
+#include "bench.h"
+#include "results.h"
+#include "eol.h"
+#include "transform.h"
+
+/**
+ * @section basic utility code.
+ */
+
+static const size_t blockSize{1 << 20};
+
+static const std::vector<std::string> transformProfiles{ "all", "indent", "long" };
+static const std::vector<std::string> transformMatrix{ "-s -2", "-s -4", "-s -8", "-t -2", "-t -4", "-t -8",
+    "-d", "-u", "-s -d", "-t -d", "-s -u -8", "-t -u -2" };
+static const size_t tabSizes[]{ 2, 4, 8 };
+
+/**
+ * @brief Transform a whole buffer with the given tab policy.
+ */
+template<typename Tab>
+static void transformWith(bool toTabs, Tab tab, const char * data, size_t length, std::string & out)
+{
+    LeadingTransform<Tab> transform{toTabs, tab};
+    transform.add(data, length, out);
+    transform.finish(out);
+}
+
+/**
+ * @brief Transform a file a block at a time with the given tab policy,
+ * then normalise the EOLs.
+ *
+ * @return int error value or 0 if no errors.
+ */
+template<typename Tab>
+static int transformStream(const TransformOptions & options, Tab tab, std::istream & is, std::ostream & os)
+{
+    LeadingTransform<Tab> transform{options.toTabs, tab};
+    EolNormaliser normaliser{options.eol};
+    std::vector<char> buffer(blockSize);
+    std::vector<char> normalised{};
+    std::string out{};
+    for (bool more{true}; more; )
+    {
+        out.clear();
+        if (is.read(buffer.data(), buffer.size()) || is.gcount())
+        {
+            if (options.leading)
+                transform.add(buffer.data(), is.gcount(), out);
+            else
+                out.assign(buffer.data(), is.gcount());
+        }
+        else
+        {
+            more = false;
+            if (options.leading)
+                transform.finish(out);
+        }
+
+        normalised.resize(EolNormaliser::space(out.size()));
+        size_t written{normaliser.add(out.data(), out.size(), normalised.data())};
+        if (!more)
+            written += normaliser.finish(normalised.data() + written);
+        if (!os.write(normalised.data(), written))
+            return 1;
+    }
+
+    return (is.bad() || !os) ? 1 : 0;
+}
+
+/**
+ * @brief Transform a whole chunk that starts at a line start and ends
+ * after a complete run of EOLs, so no state carries between chunks.
+ */
+template<typename Tab>
+static void transformChunk(const TransformOptions & options, Tab tab, const char * data, size_t length, std::vector<char> & out)
+{
+    std::string transformed{};
+    if (options.leading)
+    {
+        transformed.reserve(2 * length);
+        transformWith(options.toTabs, tab, data, length, transformed);
+        data = transformed.data();
+        length = transformed.size();
+    }
+
+    out.resize(EolNormaliser::space(length));
+    EolNormaliser normaliser{options.eol};
+    size_t written{normaliser.add(data, length, out.data())};
+    written += normaliser.finish(out.data() + written);
+    out.resize(written);
+}
+
+/**
+ * @brief Find the end of the chunk that should end near 'offset': the
+ * first byte at or after it that follows a CR or LF and is neither. The
+ * run of EOLs before it is complete however it is split into line endings,
+ * so a new line starts there.
+ *
+ * @return size_t the chunk end, or the file size if there is none.
+ */
+static size_t chunkEnd(int fd, size_t offset, size_t size)
+{
+    auto eol = [](char c) { return c == '\n' || c == '\r'; };
+
+    std::vector<char> window(64 << 10);
+    for (size_t start = offset ? offset - 1 : 0; start + 1 < size; start += window.size() - 1)
+    {
+        const ssize_t got{pread(fd, window.data(), window.size(), start)};
+        if (got < 2)
+            break;
+
+        for (ssize_t i = 1; i < got; ++i)
+            if (eol(window[i - 1]) && !eol(window[i]))
+                return start + i;
+    }
+
+    return size;
+}
+
+static std::string readFile(const std::string & fileName)
+{
+    std::ifstream is{fileName, std::ios::binary};
+    std::ostringstream os{};
+    os << is.rdbuf();
+
+    return os.str();
+}
+
+
+/**
+ * @section leading whitespace transform dispatch.
+ *
+ */
+
+/**
+ * @brief Get the leading whitespace and EOL conversions from tfc options.
+ *
+ * @param options tfc options, any of "-s" or "-t", "-d" or "-u" and a tab
+ * size.
+ * @param transform set to the conversions.
+ * @return true if the options are only conversions.
+ */
+bool parseTransform(const std::string & options, TransformOptions & transform)
+{
+    transform = TransformOptions{};
+    std::istringstream is{options};
+    for (std::string option; is >> option; )
+    {
+        if (option == "-s" || option == "--space")
+            transform.leading = true, transform.toTabs = false;
+        else if (option == "-t" || option == "--tab")
+            transform.leading = true, transform.toTabs = true;
+        else if (option == "-d" || option == "--dos")
+            transform.eol = TO_DOS;
+        else if (option == "-u" || option == "--unix")
+            transform.eol = TO_UNIX;
+        else if (option == "-2" || option == "-4" || option == "-8")
+            transform.tabSize = option[1] - '0';
+        else
+            return false;
+    }
+
+    return transform.leading || transform.eol != KEEP_EOL;
+}
+
+/**
+ * @brief Transform a whole buffer, dispatching to the specialisation for
+ * the tab size, or to the runtime tab size for any other size.
+ *
+ * @param toTabs convert to tabs if true, to spaces if false.
+ * @param tabSize tab size.
+ * @param data to transform.
+ * @param length of the data in bytes.
+ * @param out string to append the transformed data to.
+ */
+void transformBuffer(bool toTabs, size_t tabSize, const char * data, size_t length, std::string & out)
+{
+    switch (tabSize)
+    {
+    case 2: transformWith(toTabs, FixedTab<2>{}, data, length, out); break;
+    case 4: transformWith(toTabs, FixedTab<4>{}, data, length, out); break;
+    case 8: transformWith(toTabs, FixedTab<8>{}, data, length, out); break;
+    default: transformWith(toTabs, RuntimeTab{tabSize}, data, length, out); break;
+    }
+}
+
+/**
+ * @brief Write the reference transform of a file for the given tfc
+ * options.
+ *
+ * @param inputFileName of the file to transform.
+ * @param outputFileName of the file to write.
+ * @param options tfc options, any of "-s" or "-t", "-d" or "-u" and a tab
+ * size.
+ * @return int error value or 0 if no errors.
+ */
+int transformFile(const std::string & inputFileName, const std::string & outputFileName, const std::string & options)
+{
+    TransformOptions transform{};
+    if (!parseTransform(options, transform))
+        return 1;
+
+    std::ifstream is{inputFileName, std::ios::binary};
+    std::ofstream os{outputFileName, std::ios::binary|std::ios::out};
+    if (!is || !os)
+        return 1;
+
+    switch (transform.tabSize)
+    {
+    case 2: return transformStream(transform, FixedTab<2>{}, is, os);
+    case 4: return transformStream(transform, FixedTab<4>{}, is, os);
+    case 8: return transformStream(transform, FixedTab<8>{}, is, os);
+    }
+
+    return transformStream(transform, RuntimeTab{transform.tabSize}, is, os);
+}
+
+
+/**
+ * @section parallel reference transform.
+ *
+ * The input is split into chunks aligned to line starts. Workers take the
+ * chunks in order, transform each in memory and record its output size.
+ * A chunk is written with pwrite() as soon as the sizes of all the chunks
+ * before it are known, so at most one chunk per worker is held in memory.
+ */
+
+/**
+ * @brief Write the reference transform of a file using worker threads.
+ *
+ * @param inputFileName of the file to transform.
+ * @param outputFileName of the file to write.
+ * @param options tfc options, as for transformFile().
+ * @param threads number of workers, 0 for one per hardware thread.
+ * @param chunkSize nominal bytes of input per chunk.
+ * @return int error value or 0 if no errors.
+ */
+int transformFileParallel(const std::string & inputFileName, const std::string & outputFileName, const std::string & options,
+    unsigned threads, size_t chunkSize)
+{
+    TransformOptions transform{};
+    if (!parseTransform(options, transform) || !chunkSize)
+        return 1;
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const int in{open(inputFileName.c_str(), O_RDONLY)};
+    const int out{open(outputFileName.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644)};
+    if (in < 0 || out < 0)
+    {
+        if (in >= 0)
+            close(in);
+        if (out >= 0)
+            close(out);
+
+        return 1;
+    }
+
+    std::error_code ec{};
+    const size_t size = std::filesystem::file_size(inputFileName, ec);
+    std::vector<size_t> bounds{0};
+    while (!ec && bounds.back() < size)
+        bounds.push_back(chunkEnd(in, bounds.back() + chunkSize, size));
+    const size_t chunks{bounds.size() - 1};
+
+    std::vector<size_t> offsets(chunks + 1);
+    size_t ready{};             // Chunks whose output offset is known.
+    std::vector<size_t> sizes(chunks);
+    std::vector<char> done(chunks);
+    std::mutex mutex{};
+    std::condition_variable known{};
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{bool(ec)};
+
+    auto worker = [&]()
+    {
+        std::vector<char> input{};
+        std::vector<char> output{};
+        for (size_t i = next++; i < chunks; i = next++)
+        {
+            const size_t length{bounds[i + 1] - bounds[i]};
+            input.resize(length);
+            if (pread(in, input.data(), length, bounds[i]) != static_cast<ssize_t>(length))
+                failed = true;
+
+            switch (transform.tabSize)
+            {
+            case 2: transformChunk(transform, FixedTab<2>{}, input.data(), length, output); break;
+            case 4: transformChunk(transform, FixedTab<4>{}, input.data(), length, output); break;
+            case 8: transformChunk(transform, FixedTab<8>{}, input.data(), length, output); break;
+            default: transformChunk(transform, RuntimeTab{transform.tabSize}, input.data(), length, output); break;
+            }
+
+            size_t offset{};
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                sizes[i] = output.size();
+                done[i] = true;
+                for (; ready < chunks && done[ready]; ++ready)
+                    offsets[ready + 1] = offsets[ready] + sizes[ready];
+                known.notify_all();
+                known.wait(lock, [&]() { return ready >= i; });
+                offset = offsets[i];
+            }
+
+            if (pwrite(out, output.data(), output.size(), offset) != static_cast<ssize_t>(output.size()))
+                failed = true;
+        }
+    };
+
+    std::vector<std::thread> workers{};
+    for (unsigned w = 0; w < threads; ++w)
+        workers.emplace_back(worker);
+    for (auto & w : workers)
+        w.join();
+
+    close(in);
+
+    return (close(out) || failed) ? 1 : 0;
+}
+
+
+/**
+ * @section reference check and microbenchmark.
+ *
+ */
+
+/**
+ * @brief Check tfc against the reference transform for the tab and space
+ * conversion matrix on a generated file of each profile.
+ *
+ * @param dir working directory for the generated files.
+ * @param profiles names of the generation profiles.
+ * @param size of the generated input in bytes.
+ * @return int the number of conversions that did not match.
+ */
+int transformCheck(const std::string & dir, const std::vector<std::string> & profiles, size_t size)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/transform.txt"};
+    const std::string outputFileName{dir + "/transformOut.txt"};
+    const std::string expectedFileName{dir + "/transformExpected.txt"};
+
+    int failed{};
+    for (const auto & name : profiles)
+    {
+        const Profile * profile{findProfile(name)};
+        if (!profile || generateFile(inputFileName, *profile, size))
+        {
+            std::cerr << "Unable to generate " << name << '\n';
+            ++failed;
+            continue;
+        }
+
+        std::cout << std::setw(8) << name;
+        for (const auto & options : transformMatrix)
+        {
+            Usage usage{};
+            const bool same{!spawn(tfcPath + " " + options + " -i " + inputFileName + " -o " + outputFileName, usage) &&
+                !transformFile(inputFileName, expectedFileName, options) && sameContent(outputFileName, expectedFileName)};
+            std::cout << "  " << options << (same ? " ok" : " DIFFERENT");
+            if (!same)
+                ++failed;
+        }
+        std::cout << '\n';
+    }
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(outputFileName);
+    std::filesystem::remove(expectedFileName);
+
+    return failed;
+}
+
+/**
+ * @brief Time the compile time specialisation for each tab size against
+ * the runtime tab size loop on a generated file held in memory, then the
+ * EOL kernels against a plain copy.
+ *
+ * @param dir working directory for the generated file.
+ * @param size of the generated input in bytes.
+ * @param repeat number of timed runs of each, the fastest is kept.
+ * @return int error value or 0 if both gave the same output.
+ */
+int transformBench(const std::string & dir, size_t size, int repeat)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/transform.txt"};
+    if (generateFile(inputFileName, *findProfile("indent"), size))
+        return 1;
+
+    const std::string input{readFile(inputFileName)};
+    std::filesystem::remove(inputFileName);
+
+    std::cout << std::setw(6) << "Mode" << std::setw(6) << "Tab" << std::setw(12) << "Fixed" << std::setw(12) << "Runtime"
+        << std::setw(10) << "Speed-up" << "  Output\n";
+
+    int err{};
+    std::string fixed{};
+    std::string runtime{};
+    fixed.reserve(2 * input.size());
+    runtime.reserve(2 * input.size());
+    for (const bool toTabs : { false, true })
+        for (const auto tabSize : tabSizes)
+        {
+            double fixedTime{};
+            double runtimeTime{};
+            for (int run = 0; run < repeat; ++run)
+            {
+                fixed.clear();
+                Stopwatch fixedClock{};
+                transformBuffer(toTabs, tabSize, input.data(), input.size(), fixed);
+                const double fixedElapsed{fixedClock.elapsed()};
+                if (!fixedTime || fixedElapsed < fixedTime)
+                    fixedTime = fixedElapsed;
+
+                runtime.clear();
+                Stopwatch runtimeClock{};
+                transformWith(toTabs, RuntimeTab{tabSize}, input.data(), input.size(), runtime);
+                const double runtimeElapsed{runtimeClock.elapsed()};
+                if (!runtimeTime || runtimeElapsed < runtimeTime)
+                    runtimeTime = runtimeElapsed;
+            }
+
+            const bool same{fixed == runtime};
+            std::cout << std::setw(6) << (toTabs ? "-t" : "-s") << std::setw(6) << tabSize << std::fixed << std::setprecision(1)
+                << std::setw(12) << input.size() / static_cast<double>(MiB) / fixedTime << std::setw(12) << input.size() / static_cast<double>(MiB) / runtimeTime
+                << std::setprecision(2) << std::setw(10) << runtimeTime / fixedTime << "  " << (same ? "identical" : "DIFFERENT") << '\n';
+            if (!same)
+                err = 1;
+        }
+
+    std::vector<char> normalised(EolNormaliser::space(input.size()));
+    double copyTime{};
+    for (int run = 0; run < repeat; ++run)
+    {
+        Stopwatch copyClock{};
+        std::memcpy(normalised.data(), input.data(), input.size());
+        const double copyElapsed{copyClock.elapsed()};
+        if (!copyTime || copyElapsed < copyTime)
+            copyTime = copyElapsed;
+    }
+
+    std::cout << '\n' << std::setw(6) << "Mode" << std::setw(12) << "EOL kernel" << std::setw(12) << "memcpy" << '\n';
+    for (const auto mode : { TO_DOS, TO_UNIX })
+    {
+        double eolTime{};
+        for (int run = 0; run < repeat; ++run)
+        {
+            EolNormaliser normaliser{mode};
+            Stopwatch eolClock{};
+            normaliser.finish(normalised.data() + normaliser.add(input.data(), input.size(), normalised.data()));
+            const double eolElapsed{eolClock.elapsed()};
+            if (!eolTime || eolElapsed < eolTime)
+                eolTime = eolElapsed;
+        }
+        std::cout << std::setw(6) << (mode == TO_DOS ? "-d" : "-u") << std::fixed << std::setprecision(1)
+            << std::setw(12) << input.size() / static_cast<double>(MiB) / eolTime << std::setw(12) << input.size() / static_cast<double>(MiB) / copyTime << '\n';
+    }
+
+    return err;
+}
+
+/**
+ * @brief Time the parallel reference transform against the sequential one
+ * on a generated file and check both give the same output.
+ *
+ * @param dir working directory for the generated files.
+ * @param size of the generated input in bytes.
+ * @param threads number of workers, 0 for one per hardware thread.
+ * @return int error value or 0 if both gave the same output.
+ */
+int transformParallelBench(const std::string & dir, size_t size, unsigned threads)
+{
+    std::filesystem::create_directories(dir);
+    const std::string inputFileName{dir + "/transform.txt"};
+    const std::string sequentialFileName{dir + "/transformSequential.txt"};
+    const std::string parallelFileName{dir + "/transformParallel.txt"};
+    if (generateFile(inputFileName, *findProfile("all"), size))
+        return 1;
+
+    std::cout << std::setw(10) << "Options" << std::setw(12) << "Sequential" << std::setw(12) << "Parallel"
+        << std::setw(10) << "Speed-up" << "  Output\n";
+
+    int err{};
+    for (const auto & options : { "-s -d", "-t -u -8", "-u" })
+    {
+        Stopwatch sequentialClock{};
+        err |= transformFile(inputFileName, sequentialFileName, options);
+        const double sequential{sequentialClock.elapsed()};
+
+        Stopwatch parallelClock{};
+        err |= transformFileParallel(inputFileName, parallelFileName, options, threads);
+        const double parallel{parallelClock.elapsed()};
+
+        const bool same{sameContent(sequentialFileName, parallelFileName)};
+        std::cout << std::setw(10) << options << std::fixed << std::setprecision(1)
+            << std::setw(12) << size / static_cast<double>(MiB) / sequential << std::setw(12) << size / static_cast<double>(MiB) / parallel
+            << std::setprecision(2) << std::setw(10) << sequential / parallel << "  " << (same ? "identical" : "DIFFERENT") << '\n';
+        if (!same)
+            err = 1;
+    }
+
+    std::filesystem::remove(inputFileName);
+    std::filesystem::remove(sequentialFileName);
+    std::filesystem::remove(parallelFileName);
+
+    return err;
+}
+
+/**
+ * @brief Command line entry point for the reference transform.
+ *
+ *   test transform [--bench] [--size S] [--repeat N] [--profile name]...
+ *   test transform --parallel [--size S] [--threads N]
+ *
+ * @param dir working directory for the generated files.
+ * @param args command line arguments, starting with "transform".
+ * @return int error value or 0 if no errors.
+ */
+int transformCommand(const std::string & dir, const std::vector<std::string> & args)
+{
+    bool bench{};
+    bool parallel{};
+    unsigned threads{};
+    size_t size{64 << 20};
+    int repeat{5};
+    std::vector<std::string> profiles{};
+    int invalid{};
+    for (size_t i = 1; i < args.size(); ++i)
+    {
+        const bool value{i + 1 < args.size()};
+        if (args[i] == "--bench")
+            bench = true;
+        else if (args[i] == "--parallel")
+            parallel = true;
+        else if (args[i] == "--threads" && value)
+            invalid |= parseInt(args[++i], threads);
+        else if (args[i] == "--size" && value)
+            invalid |= parseSize(args[++i], size);
+        else if (args[i] == "--repeat" && value)
+            invalid |= parseInt(args[++i], repeat, 1);
+        else if (args[i] == "--profile" && value)
+            profiles.push_back(args[++i]);
+        else
+        {
+            std::cerr << "Unknown transform argument " << args[i] << '\n';
+
+            return 1;
+        }
+    }
+    if (invalid)
+        return 1;
+
+    if (parallel)
+    {
+        std::cout << "\nParallel reference transform in MiB/s on a " << size << " byte file with "
+            << (threads ? threads : std::thread::hardware_concurrency()) << " threads.\n";
+
+        return transformParallelBench(dir, size, threads);
+    }
+
+    if (bench)
+    {
+        std::cout << "\nReference transform in MiB/s on a " << size << " byte indent file in memory, fastest of " << repeat << " runs.\n";
+
+        return transformBench(dir, size, repeat);
+    }
+
+    if (profiles.empty())
+        profiles = transformProfiles;
+
+    std::cout << "\ntfc against the reference transform on " << size << " byte files.\n";
+    const int failed{transformCheck(dir, profiles, size)};
+    if (failed)
+        std::cout << failed << " conversion(s) differed from the reference.\n";
+
+    return failed ? 1 : 0;
+}
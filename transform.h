@@ -0,0 +1,175 @@
+/**
+ * @file    transform.h
+ * @author  Phil Lockett <phillockett65@gmail.com>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details at
+ * https://www.gnu.org/copyleft/gpl.html
+ *
+ * @section DESCRIPTION
+ *
+ * Reference leading whitespace transform, specialised at compile time for
+ * each tab size.
+ */
+
+#if !defined(_TRANSFORM_H__20261017_1800__INCLUDED_)
+#define _TRANSFORM_H__20261017_1800__INCLUDED_
+
+#include <string>
+#include <vector>
+
+#include "summary.h"
+#include "eol.h"
+
+
+/**
+ * @section leading whitespace transform interface.
+ *
+ * LeadingTransform gives the same leading whitespace as 'tfc -s' (to
+ * spaces) or 'tfc -t' (to tabs) and copies everything else, including the
+ * EOLs, which are then normalised separately for '-d' and '-u'. Leading
+ * whitespace starts after every CR or LF, so it is the same
+ * whichever way the EOLs are paired into lines. The Tab policy sets how
+ * columns are counted: FixedTab for a power of 2 known at compile time uses
+ * shifts and masks, RuntimeTab divides by a size chosen at run time.
+ */
+
+template<size_t N>
+struct FixedTab
+{
+    static_assert(N && !(N & (N - 1)), "tab size must be a power of 2");
+    static constexpr size_t shift{static_cast<size_t>(__builtin_ctzll(N))};
+
+    size_t next(size_t column) const { return (column | (N - 1)) + 1; }
+    size_t tabs(size_t column) const { return column >> shift; }
+    size_t spaces(size_t column) const { return column & (N - 1); }
+};
+
+struct RuntimeTab
+{
+    size_t size;
+
+    size_t next(size_t column) const { return (column / size + 1) * size; }
+    size_t tabs(size_t column) const { return column / size; }
+    size_t spaces(size_t column) const { return column % size; }
+};
+
+template<typename Tab>
+class LeadingTransform
+{
+public:
+    LeadingTransform(bool toTabs, Tab tab = Tab{}) : toTabs{toTabs}, tab{tab} {}
+
+    void add(const char * data, size_t length, std::string & out);
+    void finish(std::string & out) { if (leading) emit(out); leading = true; column = 0; }
+
+private:
+    void emit(std::string & out);
+
+    const bool toTabs;
+    const Tab tab;
+    bool leading{true};     // Still in the leading whitespace of the current line.
+    size_t column{};        // Column reached by the leading whitespace.
+
+};
+
+struct TransformOptions
+{
+    bool leading{};         // Convert leading whitespace.
+    bool toTabs{};          // To tabs for "-t", to spaces for "-s".
+    size_t tabSize{4};
+    EolMode eol{KEEP_EOL};  // TO_DOS for "-d", TO_UNIX for "-u".
+};
+
+extern bool parseTransform(const std::string & options, TransformOptions & transform);
+extern void transformBuffer(bool toTabs, size_t tabSize, const char * data, size_t length, std::string & out);
+extern int transformFile(const std::string & inputFileName, const std::string & outputFileName, const std::string & options);
+extern int transformFileParallel(const std::string & inputFileName, const std::string & outputFileName, const std::string & options,
+    unsigned threads = 0, size_t chunkSize = 16 << 20);
+
+extern int transformCheck(const std::string & dir, const std::vector<std::string> & profiles, size_t size);
+extern int transformBench(const std::string & dir, size_t size, int repeat);
+extern int transformParallelBench(const std::string & dir, size_t size, unsigned threads);
+extern int transformCommand(const std::string & dir, const std::vector<std::string> & args);
+
+
+/**
+ * @section leading whitespace transform implementation.
+ *
+ */
+
+/**
+ * @brief Output the leading whitespace reached as spaces, or as tabs
+ * followed by any spaces left over.
+ *
+ * @tparam Tab policy for the tab size.
+ * @param out string to append to.
+ */
+template<typename Tab>
+void LeadingTransform<Tab>::emit(std::string & out)
+{
+    if (toTabs)
+    {
+        out.append(tab.tabs(column), '\t');
+        out.append(tab.spaces(column), ' ');
+    }
+    else
+        out.append(column, ' ');
+}
+
+/**
+ * @brief Transform the next block of the stream.
+ *
+ * @tparam Tab policy for the tab size.
+ * @param data of the block.
+ * @param length of the block in bytes.
+ * @param out string to append the transformed block to.
+ */
+template<typename Tab>
+void LeadingTransform<Tab>::add(const char * data, size_t length, std::string & out)
+{
+    for (size_t i = 0; i < length; )
+    {
+        if (leading)
+        {
+            for (; i < length; ++i)
+                if (data[i] == ' ')
+                    ++column;
+                else if (data[i] == '\t')
+                    column = tab.next(column);
+                else
+                    break;
+
+            if (i == length)
+                break;
+
+            emit(out);
+            leading = false;
+            column = 0;
+        }
+
+        const size_t eol{findEol(data, i, length)};
+        if (eol == length)
+        {
+            out.append(data + i, length - i);
+            break;
+        }
+
+        out.append(data + i, eol + 1 - i);
+        i = eol + 1;
+        leading = true;
+    }
+}
+
+
+#endif // !defined(_TRANSFORM_H__20261017_1800__INCLUDED_)